@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ * Throughput of jfif::Decoder::feed(), at different chunk sizes,
+ * for two made-up files: one which is mostly entropy-encoded data
+ * (like a photo) and one which is mostly small segments (which
+ * stresses the marker handling).
+ */
+#include <jfif.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <iostream>
+#include <cstdio>
+
+namespace {
+
+    using Octets = std::vector<uint8_t>;
+
+    void segment(Octets& v, unsigned marker, size_t n)
+    {
+	v.push_back(0xff);
+	v.push_back(marker);
+	v.push_back((n+2) >> 8);
+	v.push_back(n+2);
+	for (size_t i = 0; i < n; i++) v.push_back(i);
+    }
+
+    void standalone(Octets& v, unsigned marker)
+    {
+	v.push_back(0xff);
+	v.push_back(marker);
+    }
+
+    /**
+     * SOI, the usual headers with a 60K APP1, then 'n' octets of
+     * entropy-encoded data with stuffing, and RSTn every 4K or so.
+     */
+    Octets photo(size_t n)
+    {
+	Octets v;
+	std::minstd_rand rng;
+	standalone(v, 0xd8);
+	segment(v, 0xe0, 14);
+	segment(v, 0xe1, 60000);
+	segment(v, 0xdb, 130);
+	segment(v, 0xc0, 15);
+	segment(v, 0xc4, 400);
+	segment(v, 0xda, 10);
+	unsigned rst = 0;
+	for (size_t i = 0; i < n; i++) {
+	    const uint8_t ch = rng();
+	    v.push_back(ch);
+	    if (ch==0xff) v.push_back(0);
+	    if (i % 4096 == 4095) standalone(v, 0xd0 + rst++ % 8);
+	}
+	standalone(v, 0xd9);
+	return v;
+    }
+
+    /**
+     * SOI, then 'n' octets worth of tiny COM segments.
+     */
+    Octets markers(size_t n)
+    {
+	Octets v;
+	standalone(v, 0xd8);
+	while (v.size() < n) segment(v, 0xfe, v.size() % 8);
+	standalone(v, 0xd9);
+	return v;
+    }
+
+    /**
+     * Decode 'v' in chunks of 'n' octets, as many times as fits in a
+     * fraction of a second, and return the rate in MB/s.
+     */
+    double rate(const Octets& v, size_t n, const jfif::Markers& keep)
+    {
+	using Clock = std::chrono::steady_clock;
+	const auto t0 = Clock::now();
+	const auto deadline = t0 + std::chrono::milliseconds(300);
+	jfif::Decoder decoder {jfif::Decoder::Mode::Full, keep};
+	size_t total = 0;
+	do {
+	    decoder.reset();
+	    auto a = v.data();
+	    const auto b = a + v.size();
+	    while (a!=b) {
+		auto c = a + std::min<size_t>(n, b - a);
+		decoder.feed(a, c);
+		a = c;
+	    }
+	    decoder.end();
+	    total += v.size();
+	} while (Clock::now() < deadline);
+
+	const std::chrono::duration<double> dt = Clock::now() - t0;
+	return total / dt.count() / 1e6;
+    }
+
+    void bench(std::ostream& os, const std::string& name,
+	       const Octets& v, const jfif::Markers& keep)
+    {
+	os << name << " (" << v.size() / 1024 << " KiB)\n";
+	for (size_t n = 1; n <= 1024*1024; n *= 4) {
+	    char buf[60];
+	    std::snprintf(buf, sizeof buf, "%10zu %10.1f MB/s\n",
+			  n, rate(v, n, keep));
+	    os << buf;
+	}
+    }
+}
+
+int main()
+{
+    const auto p = photo(4*1024*1024);
+    const auto m = markers(1024*1024);
+    bench(std::cout, "photo, keeping nothing", p, {});
+    bench(std::cout, "photo, keeping all", p, jfif::Markers::all());
+    bench(std::cout, "small segments, keeping nothing", m, {});
+    return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ * The cost of failing: decoding corrupt files with the throwing
+ * jfif::Decoder and tiff::File APIs, compared to their Status
+ * counterparts.  Like olymp does it, the Exif APP1 is looked for in
+ * a JPEG file, and then the TIFF of it is parsed.
+ */
+#include <jfif.h>
+#include <tiff/tiff.h>
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iostream>
+#include <cstdio>
+
+namespace {
+
+    using Octets = std::vector<uint8_t>;
+
+    void segment(Octets& v, unsigned marker, const Octets& data)
+    {
+	const size_t n = data.size() + 2;
+	v.push_back(0xff);
+	v.push_back(marker);
+	v.push_back(n >> 8);
+	v.push_back(n);
+	v.insert(end(v), begin(data), end(data));
+    }
+
+    void standalone(Octets& v, unsigned marker)
+    {
+	v.push_back(0xff);
+	v.push_back(marker);
+    }
+
+    /**
+     * An Exif APP1 with an IFD 0 holding an Exif IFD pointer to
+     * 'exif'.
+     */
+    Octets app1(unsigned exif)
+    {
+	Octets v {'E', 'x', 'i', 'f', 0, 0,
+		  'I', 'I', 42, 0, 8, 0, 0, 0,
+		  1, 0,
+		  0x69, 0x87, 4, 0, 1, 0, 0, 0};
+	for (unsigned i=0; i<4; i++) v.push_back(exif >> 8*i);
+	for (unsigned i=0; i<4; i++) v.push_back(0);
+	v.push_back(0);
+	v.push_back(0);
+	for (unsigned i=0; i<4; i++) v.push_back(0);
+	return v;
+    }
+
+    Octets jpeg(const Octets& app1)
+    {
+	Octets v;
+	standalone(v, 0xd8);
+	segment(v, 0xe0, Octets(14));
+	segment(v, 0xe1, app1);
+	segment(v, 0xdb, Octets(130));
+	segment(v, 0xda, Octets(10));
+	standalone(v, 0xd9);
+	return v;
+    }
+
+    struct Case {
+	std::string name;
+	Octets v;
+    };
+
+    std::vector<Case> cases()
+    {
+	const Octets good = jpeg(app1(26));
+	Octets truncated {good.begin(), good.begin() + 30};
+	Octets false_start {0x12, 0x34};
+	false_start.insert(end(false_start), begin(good), end(good));
+	Octets length = good;
+	length[4] = length[5] = 0;
+	return {{"good", good},
+		{"truncated", truncated},
+		{"false start", false_start},
+		{"illegal length", length},
+		{"bad IFD offset", jpeg(app1(0x7fffffff))}};
+    }
+
+    const jfif::Markers app1_only {jfif::marker::APP1};
+
+    /**
+     * Decode and parse 'v', throwing on failure.
+     */
+    bool throwing(jfif::Decoder& decoder, const Octets& v)
+    {
+	try {
+	    decoder.reset();
+	    decoder.feed(v.data(), v.data() + v.size());
+	    decoder.end();
+	    if (decoder.v.empty()) return false;
+	    const tiff::File f {decoder.v.front().v};
+	    return true;
+	}
+	catch (const jfif::Decoder::Error&) {}
+	catch (const tiff::Error&) {}
+	return false;
+    }
+
+    /**
+     * Decode and parse 'v', without exceptions.
+     */
+    bool status(jfif::Decoder& decoder, const Octets& v)
+    {
+	decoder.reset();
+	decoder.try_feed(v.data(), v.data() + v.size());
+	if (decoder.try_end()!=jfif::Decoder::Status::Ok) return false;
+	if (decoder.v.empty()) return false;
+	tiff::Status status;
+	const tiff::File f {tiff::Range {decoder.v.front().v}, status};
+	return status==tiff::Status::Ok;
+    }
+
+    /**
+     * Run f on 'v', as many times as fits in a fraction of a second,
+     * and return the rate in files/s.
+     */
+    template <class F>
+    double rate(F f, const Octets& v)
+    {
+	using Clock = std::chrono::steady_clock;
+	const auto t0 = Clock::now();
+	const auto deadline = t0 + std::chrono::milliseconds(300);
+	jfif::Decoder decoder {jfif::Decoder::Mode::Headers, app1_only};
+	size_t n = 0;
+	do {
+	    for (unsigned i=0; i<100; i++) f(decoder, v);
+	    n += 100;
+	} while (Clock::now() < deadline);
+
+	const std::chrono::duration<double> dt = Clock::now() - t0;
+	return n / dt.count();
+    }
+}
+
+int main()
+{
+    std::cout << "files/s       throwing        Status\n";
+    for (const Case& c : cases()) {
+	char buf[80];
+	std::snprintf(buf, sizeof buf, "%-15s %12.0f  %12.0f\n",
+		      c.name.c_str(),
+		      rate(throwing, c.v), rate(status, c.v));
+	std::cout << buf;
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#include "cache.h"
+#include "mapping.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * The on-disk record.  The timestamp is the Exif one, e.g.
+ * "2019:11:20 23:07:39", NUL-padded.
+ */
+struct Cache::Record {
+    Key key;
+    double latitude;
+    double longitude;
+    char ts[24];
+
+    bool operator< (const Record& other) const;
+    bool same(const Record& other) const;
+};
+
+/*
+ * Records are ordered by device and inode only.
+ */
+bool Cache::Record::operator< (const Record& other) const
+{
+    if (key.dev==other.key.dev) return key.ino < other.key.ino;
+    return key.dev < other.key.dev;
+}
+
+bool Cache::Record::same(const Record& other) const
+{
+    return !(*this < other) && !(other < *this);
+}
+
+namespace {
+
+    /**
+     * The file header.  The version is also a byte order mark of
+     * sorts.
+     */
+    struct Header {
+	char magic[8];
+	uint32_t version;
+	uint32_t size;
+    };
+
+    const Header header {{'o', 'l', 'y', 'm', 'p', 'c', '\n', 0},
+			 1, sizeof (Cache::Record)};
+
+    bool operator== (const Header& a, const Header& b)
+    {
+	return std::memcmp(a.magic, b.magic, sizeof a.magic)==0
+	    && a.version==b.version
+	    && a.size==b.size;
+    }
+}
+
+Cache::Key::Key(const struct stat& st)
+    : dev(st.st_dev),
+      ino(st.st_ino),
+      size(st.st_size),
+      mtime(st.st_mtim.tv_sec * INT64_C(1000000000) + st.st_mtim.tv_nsec)
+{}
+
+/**
+ * The cache stored at 'path'.  It's not an error if there's no such
+ * file, or if it's unusable; the cache is simply empty then.
+ */
+Cache::Cache(const std::string& path)
+    : path {path}
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd==-1) return;
+    map.reset(new Mapping {fd});
+    close(fd);
+
+    const size_t n = map->size();
+    if (!map->valid() || n < sizeof (Header)) return;
+    if (!(*reinterpret_cast<const Header*>(map->begin())==header)) return;
+    if ((n - sizeof (Header)) % sizeof (Record)) return;
+
+    a = reinterpret_cast<const Record*>(map->begin() + sizeof (Header));
+    b = reinterpret_cast<const Record*>(map->end());
+}
+
+Cache::~Cache() = default;
+
+/**
+ * The Metadata for the file with 'key' and serial number 'nnnn', or
+ * null if it's not in the cache.  Only looks at what was on disk
+ * when the Cache was created.
+ */
+std::unique_ptr<const Metadata> Cache::find(const Key& key,
+					    const Serial& nnnn) const
+{
+    Record rec {};
+    rec.key = key;
+    auto it = std::lower_bound(a, b, rec);
+    if (it==b || !it->same(rec)) return {};
+    if (it->key.size!=key.size || it->key.mtime!=key.mtime) return {};
+
+    const std::string ts {it->ts, strnlen(it->ts, sizeof it->ts)};
+    return std::unique_ptr<const Metadata> {
+	new Metadata {nnnn,
+		      exif::DateTimeOriginal {ts},
+		      wgs84::Coordinate {it->latitude, it->longitude}}};
+}
+
+/**
+ * Remember 'meta' for the file with 'key', until save().
+ */
+void Cache::insert(const Key& key, const Metadata& meta)
+{
+    Record rec {};
+    rec.key = key;
+    rec.latitude = meta.coordinate().lat();
+    rec.longitude = meta.coordinate().lon();
+    const std::string& ts = meta.timestamp().str();
+    ts.copy(rec.ts, sizeof rec.ts - 1);
+    added.push_back(rec);
+}
+
+/**
+ * Merge the inserted records with the old ones and write the result
+ * to disk, if there's anything new.  The old file is replaced using
+ * rename(2), so a reader never sees half of it.  Returns false, with
+ * errno set, on failure.
+ */
+bool Cache::save()
+{
+    if (added.empty()) return true;
+
+    std::stable_sort(begin(added), end(added));
+    std::vector<Record> v;
+    v.reserve((b - a) + added.size());
+    auto i = a;
+    auto j = begin(added);
+    while (j!=end(added)) {
+	if (std::next(j)!=end(added) && j->same(*std::next(j))) {
+	    j++;
+	}
+	else if (i!=b && *i < *j) {
+	    v.push_back(*i++);
+	}
+	else {
+	    if (i!=b && i->same(*j)) i++;
+	    v.push_back(*j++);
+	}
+    }
+    v.insert(end(v), i, b);
+
+    const std::string tmp = path + ".new";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(&header, sizeof header, 1, f)==1;
+    if (ok && v.size()) {
+	ok = std::fwrite(v.data(), sizeof v[0], v.size(), f)==v.size();
+    }
+    ok = std::fclose(f)==0 && ok;
+    if (ok) ok = std::rename(tmp.c_str(), path.c_str())==0;
+    if (!ok) {
+	const int err = errno;
+	std::remove(tmp.c_str());
+	errno = err;
+	return false;
+    }
+    added.clear();
+    return true;
+}
@@ -0,0 +1,71 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_CACHE_H
+#define OLYMP_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "metadata.h"
+
+struct stat;
+class Mapping;
+
+/**
+ * A persistent cache of Metadata, so that files which haven't changed
+ * since the last run don't have to be read and decoded again.
+ *
+ * A file is identified by a Key: device, inode, size and mtime, as
+ * given by one stat(2).  A file with an unchanged Key is assumed to
+ * have unchanged Exif data.  The serial number isn't cached: it comes
+ * from the file name, which may have changed since.
+ *
+ * On disk, the cache is a small header followed by fixed-size
+ * records, sorted by device and inode.  It's memory-mapped and
+ * searched in place.  The byte order is the native one, so a cache
+ * from another kind of machine is ignored (and later replaced) like
+ * any other broken one.  New records are kept in memory until save()
+ * merges them in and atomically replaces the file.  There is at most
+ * one record per inode; when a file changes, its record is replaced.
+ *
+ * find() may be called from several threads at once; insert() and
+ * save() may not.
+ */
+class Cache {
+public:
+    struct Key {
+	Key() = default;
+	explicit Key(const struct stat& st);
+	uint64_t dev = 0;
+	uint64_t ino = 0;
+	uint64_t size = 0;
+	int64_t mtime = 0;
+    };
+
+    explicit Cache(const std::string& path);
+    ~Cache();
+    Cache(const Cache&) = delete;
+    Cache& operator= (const Cache&) = delete;
+
+    std::unique_ptr<const Metadata> find(const Key& key,
+					 const Serial& nnnn) const;
+    void insert(const Key& key, const Metadata& meta);
+    bool save();
+
+    struct Record;
+
+private:
+    const std::string path;
+    std::unique_ptr<const Mapping> map;
+    const Record* a = nullptr;
+    const Record* b = nullptr;
+    std::vector<Record> added;
+};
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ * Scanning entropy-encoded data for the next marker.  Most of a JPEG
+ * file is entropy-encoded data, and in it, an FF octet is always
+ * followed by a 00 ("stuffing") except where there's a marker.  So
+ * what we want is the first FF not followed by 00, and the vector
+ * versions find it 16 or 32 octets at a time: one mask for the FFs,
+ * one for the 00s shifted one step, and FF 00 pairs cancel out.
+ */
+#include "entropy.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OLYMP_HAVE_X86
+#endif
+
+namespace {
+
+    constexpr uint8_t ff = 0xff;
+    constexpr uint8_t nil = 0;
+
+    using Scan = const uint8_t* (*)(const uint8_t*, const uint8_t*);
+
+    /**
+     * The best scanner this CPU can run.
+     */
+    Scan best()
+    {
+	using namespace jfif::entropy;
+	if (have_avx2()) return avx2;
+	if (have_sse2()) return sse2;
+	return scalar;
+    }
+}
+
+namespace jfif {
+
+    /**
+     * The first FF in [a, b) which isn't followed by 00, or b if
+     * there is none.  An FF at the very end is returned too, since
+     * the octet after it is unknown.
+     *
+     * This is where the interesting things happen in entropy-encoded
+     * data: markers, RSTn included, or FF padding before them.
+     */
+    const uint8_t* scan(const uint8_t* a, const uint8_t* b)
+    {
+	static const Scan f = best();
+	return f(a, b);
+    }
+}
+
+const uint8_t* jfif::entropy::scalar(const uint8_t* a, const uint8_t* b)
+{
+    while (a!=b) {
+	if (*a!=ff) {
+	    a++;
+	    continue;
+	}
+	if (a+1==b || a[1]!=nil) return a;
+	a += 2;
+    }
+    return b;
+}
+
+#ifdef OLYMP_HAVE_X86
+
+__attribute__((target("sse2")))
+const uint8_t* jfif::entropy::sse2(const uint8_t* a, const uint8_t* b)
+{
+    const __m128i ffs = _mm_set1_epi8(char(ff));
+    const __m128i nils = _mm_setzero_si128();
+
+    while (b - a > 16) {
+	auto p = reinterpret_cast<const __m128i*>(a);
+	auto q = reinterpret_cast<const __m128i*>(a+1);
+	const unsigned m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(p), ffs));
+	if (m) {
+	    const unsigned z = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(q), nils));
+	    const unsigned hit = m & ~z;
+	    if (hit) return a + __builtin_ctz(hit);
+	    /* The last FF in the block may be stuffed by the first
+	     * octet of the next one; z has already covered that.
+	     */
+	}
+	a += 16;
+    }
+    return scalar(a, b);
+}
+
+__attribute__((target("avx2")))
+const uint8_t* jfif::entropy::avx2(const uint8_t* a, const uint8_t* b)
+{
+    const __m256i ffs = _mm256_set1_epi8(char(ff));
+    const __m256i nils = _mm256_setzero_si256();
+
+    while (b - a > 32) {
+	auto p = reinterpret_cast<const __m256i*>(a);
+	auto q = reinterpret_cast<const __m256i*>(a+1);
+	const unsigned m = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(p), ffs));
+	if (m) {
+	    const unsigned z = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(q), nils));
+	    const unsigned hit = m & ~z;
+	    if (hit) return a + __builtin_ctz(hit);
+	}
+	a += 32;
+    }
+    return sse2(a, b);
+}
+
+bool jfif::entropy::have_sse2()
+{
+    return __builtin_cpu_supports("sse2");
+}
+
+bool jfif::entropy::have_avx2()
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+#else
+
+const uint8_t* jfif::entropy::sse2(const uint8_t* a, const uint8_t* b)
+{
+    return scalar(a, b);
+}
+
+const uint8_t* jfif::entropy::avx2(const uint8_t* a, const uint8_t* b)
+{
+    return scalar(a, b);
+}
+
+bool jfif::entropy::have_sse2() { return false; }
+bool jfif::entropy::have_avx2() { return false; }
+
+#endif
@@ -0,0 +1,25 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_ENTROPY_H
+#define OLYMP_ENTROPY_H
+
+#include <cstdint>
+
+namespace jfif {
+
+    const uint8_t* scan(const uint8_t* a, const uint8_t* b);
+
+    namespace entropy {
+	const uint8_t* scalar(const uint8_t* a, const uint8_t* b);
+	const uint8_t* sse2(const uint8_t* a, const uint8_t* b);
+	const uint8_t* avx2(const uint8_t* a, const uint8_t* b);
+	bool have_sse2();
+	bool have_avx2();
+    }
+}
+
+#endif
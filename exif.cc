@@ -11,7 +11,7 @@ using exif::DateTimeOriginal;
 
 
 DateTimeOriginal::DateTimeOriginal(const tiff::File& tiff)
-    : s {tiff.exif.find<Type>(tag)}
+    : s {Field {tiff}.val.str()}
 {}
 
 /**
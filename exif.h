@@ -16,25 +16,32 @@
  */
 namespace exif {
 
-    template <class T, unsigned Tag>
-    struct Field {
-	static constexpr unsigned tag = Tag;
-	using Type = T;
+    /**
+     * Like gps::Field, but in the Exif IFD.
+     */
+    template <class T, unsigned Tag, unsigned Count = 1>
+    struct Field : public tiff::Field<T, Tag, Count> {
+	Field() = default;
+	explicit Field(const tiff::File& file) { file.exif.extract(*this); }
     };
 
     /* In original, something like "2019:11:20 23:07:39" but we want
      * to access it as "2019-11-20" and "23:07".  We don't sanity-check
      * very carefully.
      */
-    class DateTimeOriginal : public Field<tiff::type::Ascii, 0x9003> {
+    class DateTimeOriginal {
     public:
+	using Field = exif::Field<tiff::type::Ascii, 0x9003>;
+
 	explicit DateTimeOriginal(const tiff::File& tiff);
+	explicit DateTimeOriginal(const std::string& s) : s{s} {}
 
 	std::string date() const;
 	std::string hhmm() const;
 	std::string hhmmss() const;
 	bool valid() const;
 	bool near(const DateTimeOriginal& other) const;
+	const std::string& str() const { return s; }
 
     private:
 	const std::string s;
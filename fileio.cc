@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#include "fileio.h"
+
+#include "mapping.h"
+#include "uring.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <unistd.h>
+#include <fcntl.h>
+
+/**
+ * Set 'io' from its name, "read", "mmap" or "uring".  Returns false
+ * if there's no such Io.
+ */
+bool io_of(const char* s, Io& io)
+{
+    if (std::strcmp(s, "read")==0) {
+	io = Io::Read;
+    }
+    else if (std::strcmp(s, "mmap")==0) {
+	io = Io::Mmap;
+    }
+    else if (std::strcmp(s, "uring")==0) {
+	io = Io::Uring;
+    }
+    else {
+	return false;
+    }
+    return true;
+}
+
+Fd::Fd(const Entry& file, Cost& cost)
+    : fd {openat(file.at(), file.name.c_str(), O_RDONLY)},
+      cost_(cost)
+{
+    cost.calls++;
+    if (fd==-1) throw OpenError {};
+}
+
+Fd::~Fd()
+{
+    close(fd);
+    cost_.calls++;
+}
+
+ssize_t Fd::pread(void *buf, size_t count, off_t offset) const
+{
+    if (seekable_) {
+	cost_.calls++;
+	auto res = ::pread(fd, buf, count, offset);
+	if (res > 0) cost_.bytes += res;
+	if (res!=-1 || errno!=ESPIPE) return res;
+	seekable_ = false;
+    }
+    return read(buf, count, offset);
+}
+
+/**
+ * Like pread(), for an fd which cannot seek and has been read up to
+ * 'pos'.  Whatever is between there and 'offset' is read and thrown
+ * away; going backwards fails with ESPIPE.
+ */
+ssize_t Fd::read(void *buf, size_t count, off_t offset) const
+{
+    if (offset < pos) {
+	errno = ESPIPE;
+	return -1;
+    }
+    while (pos < offset) {
+	char junk[4096];
+	const size_t n = std::min<off_t>(sizeof junk, offset - pos);
+	cost_.calls++;
+	auto res = ::read(fd, junk, n);
+	if (res==-1) return res;
+	if (res==0) return 0;
+	cost_.bytes += res;
+	pos += res;
+    }
+    cost_.calls++;
+    auto res = ::read(fd, buf, count);
+    if (res > 0) {
+	cost_.bytes += res;
+	pos += res;
+    }
+    return res;
+}
+
+void Fd::advise(off_t offset, off_t len, int advice) const
+{
+    cost_.calls++;
+    posix_fadvise(fd, offset, len, advice);
+}
+
+/**
+ * The file 'fd' as a Mapping, if possible.  Otherwise null, and
+ * 'fd' has to be read.  Counts fstat(2), mmap(2) and munmap(2) into
+ * its Cost, and all of the file as mapped.
+ */
+std::unique_ptr<const Mapping> mapping_of(const Fd& fd)
+{
+    Cost& cost = fd.cost();
+    std::unique_ptr<const Mapping> map {new Mapping {fd.get()}};
+    cost.calls++;
+    if (!map->valid()) {
+	map.reset();
+    }
+    else {
+	cost.calls += 2;
+	cost.bytes += map->size();
+    }
+    return map;
+}
+
+namespace {
+
+    bool enough(const Reading& reading, const jfif::Decoder& decoder)
+    {
+	return reading.enough && reading.enough(decoder);
+    }
+
+    /**
+     * How much to read next, for 'decoder'.  Normally a chunk, but
+     * once inside a segment (like the APP1, which tends to be
+     * 10--60K) the rest of it, so it lands in one read.
+     */
+    size_t read_size(const Reading& reading, const jfif::Decoder& decoder)
+    {
+	return std::max(reading.chunk, decoder.wanted());
+    }
+
+    /**
+     * Skip the data 'decoder' doesn't need, rather than read it.  All
+     * but the last octet, so that a file which ends early is noticed
+     * just as if it had been read.  Returns the number of octets
+     * skipped.
+     */
+    size_t skip(jfif::Decoder& decoder)
+    {
+	const size_t n = decoder.skippable();
+	if (n < 2) return 0;
+	decoder.skip(n-1);
+	return n-1;
+    }
+}
+
+/**
+ * Read the first chunk of open file 'fd' into 'head', and sniff it.
+ * Normally that's a single read, but a pipe may deliver less than it
+ * will eventually have, so there the rest of the chunk is read too.
+ * May throw.
+ */
+Format head_of(const Fd& fd, const Reading& reading,
+	       std::vector<uint8_t>& head)
+{
+    head.resize(reading.chunk);
+    size_t n = 0;
+    while (n < head.size()) {
+	auto res = fd.pread(head.data() + n, head.size() - n, n);
+	if (res==-1) throw IOError {};
+	n += res;
+	if (res==0 || fd.seekable()) break;
+    }
+    head.resize(n);
+    return sniff(head.data(), head.data() + head.size());
+}
+
+/**
+ * Feed 'decoder' from open file 'fd', according to 'reading'; its
+ * 'head' has already been read by head_of().  Doesn't end() the
+ * decoder.  Decoding errors are left in the decoder's status(); only
+ * I/O errors are thrown.
+ */
+void feed(jfif::Decoder& decoder, const Fd& fd, const Reading& reading,
+	  const std::vector<uint8_t>& head)
+{
+    thread_local std::vector<uint8_t> buf;
+    off_t offset = head.size();
+
+    decoder.try_feed(head.data(), head.data() + head.size());
+    if (enough(reading, decoder) || decoder.done() || head.empty()) return;
+    offset += skip(decoder);
+
+    bool sequential = offset >= reading.window;
+    if (sequential) {
+	fd.advise(0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    else {
+	fd.advise(offset, reading.window - offset, POSIX_FADV_WILLNEED);
+    }
+
+    while (!decoder.done()) {
+	buf.resize(read_size(reading, decoder));
+	auto res = fd.pread(buf.data(), buf.size(), offset);
+	if (res==-1) throw IOError {};
+	if (res==0) break;
+	offset += res;
+
+	decoder.try_feed(buf.data(), buf.data() + res);
+	if (enough(reading, decoder)) break;
+	offset += skip(decoder);
+	if (offset >= reading.window && !sequential) {
+	    fd.advise(0, 0, POSIX_FADV_SEQUENTIAL);
+	    sequential = true;
+	}
+    }
+}
+
+Batch::Batch(Uring& ring,
+	     jfif::Decoder::Mode mode, const jfif::Markers& keep,
+	     const Reading& reading,
+	     Sink sink)
+    : ring{ring},
+      mode{mode},
+      keep{keep},
+      reading{reading},
+      sink{sink},
+      slots(ring.size() / 2)
+{}
+
+Batch::~Batch()
+{
+    try {
+	while (inflight) pump();
+    }
+    catch (const IOError&) {}
+}
+
+void Batch::push(const Entry& file, bool wanted)
+{
+    while (tail - next == slots.size()) {
+	pump();
+	consume();
+    }
+
+    const size_t n = tail++ % slots.size();
+    Slot& s = slots[n];
+    s.file = file;
+    if (s.decoder) {
+	s.decoder->reset();
+    }
+    else {
+	s.decoder.reset(new jfif::Decoder {mode, keep});
+    }
+    s.fd = -1;
+    s.offset = 0;
+    s.format = Format::Unknown;
+    s.done = !wanted;
+    s.error = nullptr;
+    s.cost = {};
+
+    if (wanted) {
+	ring.openat(s.file.at(), s.file.name.c_str(), O_RDONLY, n);
+	s.cost.calls++;
+	inflight++;
+    }
+    consume();
+}
+
+void Batch::end()
+{
+    while (next != tail) {
+	consume();
+	if (next != tail) pump();
+    }
+    while (inflight) pump();
+}
+
+/**
+ * Submit what's queued, wait for something to complete, and
+ * act on all completions.  If the kernel is busy, nothing may have
+ * been submitted, but completions are reaped all the same, so that
+ * the next pump() can submit.  Throws if the ring is broken.
+ */
+void Batch::pump()
+{
+    const int err = ring.submit(inflight ? 1 : 0);
+    if (err && err!=EAGAIN && err!=EBUSY) throw IOError {err};
+    uint64_t data;
+    int res;
+    while (ring.reap(data, res)) {
+	inflight--;
+	if (data!=closing()) complete(data, res);
+    }
+}
+
+/**
+ * Pass the finished files at the head of the queue to the sink.
+ */
+void Batch::consume()
+{
+    while (next != tail) {
+	Slot& s = slots[next % slots.size()];
+	if (!s.done) break;
+	sink(s.file, s.format, *s.decoder, s.error, s.cost);
+	next++;
+    }
+}
+
+/**
+ * The open or read of slot 'n' completed with 'res'.
+ */
+void Batch::complete(size_t n, int res)
+{
+    Slot& s = slots[n];
+    jfif::Decoder& decoder = *s.decoder;
+    try {
+	if (res < 0 && s.fd==-1) throw OpenError {-res};
+	if (res < 0) throw IOError {-res};
+	if (s.fd==-1) {
+	    s.fd = res;
+	    return read(n);
+	}
+
+	if (!s.offset) {
+	    s.format = sniff(s.buf.data(), s.buf.data() + res);
+	    if (s.format!=Format::Jpeg) {
+		s.cost.bytes += res;
+		return finish(s);
+	    }
+	}
+
+	if (res) {
+	    decoder.try_feed(s.buf.data(), s.buf.data() + res);
+	    s.offset += res;
+	    s.cost.bytes += res;
+	    if (enough(reading, decoder)) return finish(s);
+	    s.offset += skip(decoder);
+	    if (!decoder.done()) return read(n);
+	}
+	decoder.try_end();
+    }
+    catch (...) {
+	s.error = std::current_exception();
+    }
+    finish(s);
+}
+
+void Batch::read(size_t n)
+{
+    Slot& s = slots[n];
+    s.buf.resize(read_size(reading, *s.decoder));
+    ring.read(s.fd, s.buf.data(), s.buf.size(), s.offset, n);
+    s.cost.calls++;
+    inflight++;
+}
+
+/**
+ * Done with 's', one way or another.  Close its file; in the
+ * background unless the ring is full.
+ */
+void Batch::finish(Slot& s)
+{
+    if (s.fd!=-1) {
+	s.cost.calls++;
+	if (inflight < ring.size()) {
+	    ring.close(s.fd, closing());
+	    inflight++;
+	}
+	else {
+	    close(s.fd);
+	}
+    }
+    s.done = true;
+}
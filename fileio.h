@@ -0,0 +1,194 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ * Getting the contents of files into a jfif::Decoder, in the ways
+ * olymp and seg share: read(2) them, mmap(2) them, or read them in
+ * batches using io_uring(7).
+ */
+#ifndef OLYMP_FILEIO_H
+#define OLYMP_FILEIO_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <cerrno>
+
+#include <sys/types.h>
+
+#include "jfif.h"
+#include "sniff.h"
+#include "walk.h"
+
+class Mapping;
+class Uring;
+
+/**
+ * How to get at the contents of files: read(2) them, mmap(2) them
+ * and decode them in place, or read(2) them in batches using
+ * io_uring(7).
+ */
+enum class Io {
+    Read,
+    Mmap,
+    Uring
+};
+
+bool io_of(const char* s, Io& io);
+
+/**
+ * An I/O error, and its errno value.
+ */
+struct IOError {
+    IOError() : err {errno} {}
+    explicit IOError(int err) : err {err} {}
+    const int err;
+};
+
+/**
+ * An IOError from opening the file, as opposed to reading it.
+ */
+struct OpenError: IOError {
+    OpenError() = default;
+    explicit OpenError(int err) : IOError {err} {}
+};
+
+/**
+ * What looking at a file cost: the number of system calls (or
+ * io_uring operations, which stand in for them) and the number of
+ * octets read or mapped.
+ */
+struct Cost {
+    unsigned calls = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * Minimal wrapper for the opened-for-reading fd used here.  Keeps
+ * track of its Cost.
+ *
+ * pread() works on things which cannot seek, too, like pipes: then
+ * the file is read(2) sequentially instead, and the octets before the
+ * offset asked for are read and thrown away.  So the offsets have to
+ * increase.
+ */
+class Fd {
+public:
+    Fd(const Entry& file, Cost& cost);
+    ~Fd();
+    Fd(const Fd&) = delete;
+    Fd& operator= (const Fd&) = delete;
+
+    int get() const { return fd; }
+    Cost& cost() const { return cost_; }
+    bool seekable() const { return seekable_; }
+
+    ssize_t pread(void *buf, size_t count, off_t offset) const;
+    void advise(off_t offset, off_t len, int advice) const;
+
+private:
+    const int fd;
+    Cost& cost_;
+    mutable bool seekable_ = true;
+    mutable off_t pos = 0;
+
+    ssize_t read(void *buf, size_t count, off_t offset) const;
+};
+
+std::unique_ptr<const Mapping> mapping_of(const Fd& fd);
+
+/**
+ * How to read a file into a Decoder: 'chunk' octets at a time, or
+ * all of a segment if the decoder wants that, until the decoder is
+ * done, the file ends, or it has found 'enough'.  The data of
+ * segments which aren't kept is skipped.
+ *
+ * The first chunk is the head of the file, which tells what Format
+ * it is.  Only for a JPEG file is the rest read; then the first
+ * 'window' octets are asked for up front, and past them the kernel is
+ * told we read sequentially.
+ */
+struct Reading {
+    size_t chunk;
+    off_t window;
+    std::function<bool(const jfif::Decoder&)> enough;
+};
+
+Format head_of(const Fd& fd, const Reading& reading,
+	       std::vector<uint8_t>& head);
+void feed(jfif::Decoder& decoder, const Fd& fd, const Reading& reading,
+	  const std::vector<uint8_t>& head);
+
+/**
+ * Reading many files at once, using io_uring(7), each into a
+ * Decoder of its own.  Up to half a ring of files are in flight;
+ * their opens go to the kernel together, and then their reads.  A
+ * file's next read is only issued if its Decoder needs more data,
+ * just like in feed(), and only if its head is JPEG.
+ *
+ * Like Ordered, this passes the results to a sink, in the order the
+ * files were pushed.  A result is the Format and the Decoder (after
+ * try_end(), unless it had found enough; decoding errors are in its
+ * status()) or the exception the reading threw.  Files pushed as not
+ * 'wanted' aren't touched at all, but still get passed to the sink,
+ * with an empty Decoder and Format::Unknown.  So do files which
+ * aren't JPEG, but with their Format.
+ *
+ * If the ring itself fails, push() and end() throw IOError; the
+ * files not passed to the sink by then are lost.
+ */
+class Batch {
+public:
+    using Sink = std::function<void(const Entry& file,
+				    Format format,
+				    const jfif::Decoder& decoder,
+				    std::exception_ptr error,
+				    const Cost& cost)>;
+
+    Batch(Uring& ring,
+	  jfif::Decoder::Mode mode, const jfif::Markers& keep,
+	  const Reading& reading,
+	  Sink sink);
+    ~Batch();
+    Batch(const Batch&) = delete;
+    Batch& operator= (const Batch&) = delete;
+
+    void push(const Entry& file, bool wanted);
+    void end();
+
+private:
+    struct Slot {
+	Entry file;
+	std::unique_ptr<jfif::Decoder> decoder;
+	std::vector<uint8_t> buf;
+	int fd = -1;
+	off_t offset = 0;
+	Format format = Format::Unknown;
+	bool done = false;
+	std::exception_ptr error;
+	Cost cost;
+    };
+
+    Uring& ring;
+    const jfif::Decoder::Mode mode;
+    const jfif::Markers keep;
+    const Reading reading;
+    const Sink sink;
+    std::vector<Slot> slots;
+    unsigned inflight = 0;
+
+    // sequence numbers: next to consume, next to push
+    size_t next = 0;
+    size_t tail = 0;
+
+    uint64_t closing() const { return slots.size(); }
+    void pump();
+    void consume();
+    void complete(size_t n, int res);
+    void read(size_t n);
+    void finish(Slot& s);
+};
+
+#endif
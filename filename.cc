@@ -112,3 +112,22 @@ std::string neighbour(const std::string& path, const std::string& filename)
     result += filename;
     return result;
 }
+
+/**
+ * The extension of the file name in 'path', including the dot, or ""
+ * if it has none.
+ *
+ * foo/bar.jpg -> .jpg
+ * foo.d/bar   ->
+ * .bar        ->
+ */
+std::string extension(const std::string& path)
+{
+    auto a = begin(path);
+    auto b = end(path);
+    auto c = find_last(a, b, '/');
+    if (c!=b) a = ++c;
+    if (a==b) return "";
+    c = find_last(a+1, b, '.');
+    return {c, b};
+}
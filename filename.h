@@ -35,5 +35,6 @@ std::ostream& operator<< (std::ostream& os, const Serial& val)
 Serial serial(const std::string& path);
 
 std::string neighbour(const std::string& path, const std::string& filename);
+std::string extension(const std::string& path);
 
 #endif
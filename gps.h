@@ -15,42 +15,16 @@
  * attributes.  See e.g. CIPA DC-008-2012.
  *
  * Possibly it's daft to model each attribute as a distinct type.
+ *
+ * A Field can be looked up on its own, or default-constructed and
+ * extracted together with others from file.gps.
  */
 namespace gps {
 
     template <class T, unsigned Tag, unsigned Count = 1>
-    struct Field {
-	static constexpr unsigned tag = Tag;
-	static constexpr unsigned count = Count;
-	using Type = T;
-
-	Field(const tiff::File& file)
-	    : val {tiff::find<Type, count>(file.gps, tag)}
-	{}
-
-	optional<std::array<typename Type::value_type, count>> val;
-    };
-
-    template <class T, unsigned Tag>
-    struct Field<T, Tag, 1> {
-	static constexpr unsigned tag = Tag;
-	static constexpr unsigned count = 1;
-	using Type = T;
-
-	Field(const tiff::File& file)
-	    : val {tiff::find<Type>(file.gps, tag)}
-	{}
-
-	optional<typename Type::value_type> val;
-    };
-
-    template <unsigned Tag>
-    struct Field<tiff::type::Ascii, Tag, 1u> {
-
-	Field(const tiff::File& file)
-	    : val {file.gps.find<tiff::type::Ascii>(Tag)}
-	{}
-	std::string val;
+    struct Field : public tiff::Field<T, Tag, Count> {
+	Field() = default;
+	Field(const tiff::File& file) { file.gps.extract(*this); }
     };
 
     typedef Field<tiff::type::Ascii,    0x01>    LatitudeRef;
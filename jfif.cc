@@ -4,6 +4,7 @@
  *
  */
 #include "jfif.h"
+#include "entropy.h"
 
 #include <algorithm>
 #include <iterator>
@@ -25,35 +26,86 @@ namespace {
     {
 	return ch==0x01 || (0xd0 <= ch && ch <=0xd9);
     }
+
+    bool rst(unsigned ch)
+    {
+	return 0xd0 <= ch && ch <= 0xd7;
+    }
 }
 
 namespace jfif {
 
+    namespace identifier {
+	const std::string Exif {"Exif\0\0", 6};
+	const std::string XMP {"http://ns.adobe.com/xap/1.0/\0", 29};
+    }
+
     /**
      * Helper for growing segments incrementally and pushing them
-     * onto a vector of found segments.
+     * onto a vector of found segments, and their views onto another.
+     * Segments with markers not in 'keep' are skipped; only their
+     * views are pushed.
+     *
+     * The data buffers of the found segments are recycled by reset(),
+     * so a reused Accumulator eventually stops allocating.  Only
+     * buffers which hold memory are kept, and no more of them than
+     * there have been segments in one stream.
      */
     struct Accumulator {
-	explicit Accumulator(std::vector<Segment>& dst) : dst(dst) {}
+	Accumulator(std::vector<Segment>& dst,
+		    std::vector<View>& views,
+		    const Markers& keep)
+	    : dst(dst),
+	      views(views),
+	      keep(keep)
+	{}
 	Accumulator(const Accumulator&) = delete;
 	Accumulator& operator= (const Accumulator&) = delete;
 
-	void emit(unsigned ch);
+	void reset();
+	void emit(unsigned ch, size_t offset);
 	void begin(unsigned ch);
 	void msb(unsigned n);
-	void lsb(unsigned n);
+	bool lsb(unsigned n, size_t offset);
+	void skip(size_t n);
 	const uint8_t* feed(const uint8_t *a, const uint8_t *b);
+	const uint8_t* identify(const uint8_t *a, const uint8_t *b);
 
 	uint8_t marker;
 	unsigned missing = 0;
+	View view;
 	std::vector<uint8_t> v;
 	std::vector<Segment>& dst;
+	std::vector<View>& views;
+	const Markers keep;
+	bool copy = false;
+	const std::string* id = nullptr;
+	std::vector<std::vector<uint8_t>> spare;
+	size_t most = 0;
     };
 
-    // Emit a standalone segment.
-    void Accumulator::emit(unsigned ch)
+    // Forget everything, but keep the buffers.
+    void Accumulator::reset()
     {
-	dst.emplace_back(ch, std::vector<uint8_t>{});
+	most = std::max(most, dst.size());
+	for (auto& seg : dst) {
+	    if (!seg.v.capacity() || spare.size() >= most) continue;
+	    seg.v.clear();
+	    spare.push_back(std::move(seg.v));
+	}
+	dst.clear();
+	views.clear();
+	v.clear();
+	missing = 0;
+	copy = false;
+	id = nullptr;
+    }
+
+    // Emit a standalone segment, ending at 'offset'.
+    void Accumulator::emit(unsigned ch, size_t offset)
+    {
+	if (keep.has(ch)) dst.emplace_back(ch, std::vector<uint8_t>{});
+	views.emplace_back(ch, offset, 0);
     }
 
     // Begin a normal segment with marker 'ch'.
@@ -61,6 +113,8 @@ namespace jfif {
     {
 	marker = ch;
 	missing = 0;
+	copy = keep.has(ch);
+	id = keep.id(ch);
     }
 
     // Accept the 8 MSB of a segment length.
@@ -69,15 +123,32 @@ namespace jfif {
 	missing = n << 8;
     }
 
-    // Accept the 8 LSB of a segment length.
-    void Accumulator::lsb(unsigned n)
+    // Accept the 8 LSB of a segment length; the data starts
+    // at 'offset'.  Returns false if the length is illegal.
+    bool Accumulator::lsb(unsigned n, size_t offset)
     {
 	missing |= n;
-	if (missing < 2) throw Decoder::IllegalLength {};
+	if (missing < 2) return false;
 	missing -= 2;
-	v.reserve(missing);
-	v.resize(0);
+	view = {marker, offset, missing};
+	if (copy) {
+	    if (!v.capacity() && !spare.empty()) {
+		std::swap(v, spare.back());
+		spare.pop_back();
+	    }
+	    if (!id) v.reserve(missing);
+	    v.resize(0);
+	}
 	if (!missing) feed(nullptr, nullptr);
+	return true;
+    }
+
+    // Assuming we're in a segment which isn't copied, pretend
+    // 'n' octets of it were fed.
+    void Accumulator::skip(size_t n)
+    {
+	missing -= n;
+	if (!missing) views.push_back(view);
     }
 
     // Assuming we're building a segment, drain [a, b)
@@ -86,25 +157,82 @@ namespace jfif {
 				     const uint8_t *b)
     {
 	auto c = std::min(a+missing, b);
-	append(v, a, c);
 	missing -= c - a;
+	if (copy && id) a = identify(a, c);
+	if (copy) append(v, a, c);
 	if (!missing) {
-	    dst.emplace_back(marker, v);
+	    if (copy) {
+		dst.emplace_back();
+		dst.back().marker = marker;
+		std::swap(dst.back().v, v);
+	    }
+	    views.push_back(view);
+	}
+	return c;
+    }
+
+    // Assuming we're building a segment which has to start with 'id',
+    // drain just enough of [a, b) into it to see if it does. Stop
+    // copying if it doesn't. Returns the rest of [a, b).
+    const uint8_t* Accumulator::identify(const uint8_t *a,
+					 const uint8_t *b)
+    {
+	const auto c = std::min(b, a + (id->size() - v.size()));
+	append(v, a, c);
+	if (!std::equal(v.begin(), v.end(), id->begin())) {
+	    copy = false;
+	}
+	else if (v.size()==id->size()) {
+	    id = nullptr;
+	    v.reserve(view.size);
+	}
+	else if (!missing) {
+	    copy = false;
 	}
 	return c;
     }
 }
 
-Decoder::Decoder()
-    : acc {std::make_unique<Accumulator>(v)},
+Decoder::Decoder(Mode mode, const Markers& keep)
+    : acc {std::make_unique<Accumulator>(v, views, keep)},
+      mode {mode},
       state {State::Start}
 {}
 
 Decoder::~Decoder() = default;
 
+/**
+ * Make the decoder ready for a new stream, just as if it was newly
+ * constructed with the same Mode and Markers.  The difference is
+ * that it keeps its buffers: once it has seen a few files, decoding
+ * another one doesn't allocate any memory.  The old Segments in 'v'
+ * are gone, though.
+ */
+void Decoder::reset()
+{
+    acc->reset();
+    entropy.clear();
+    state = State::Start;
+    error = Status::Ok;
+    offset = 0;
+    stretch = {};
+}
+
 void Decoder::feed(const uint8_t *a, const uint8_t *b)
+{
+    raise(try_feed(a, b));
+}
+
+/**
+ * Like feed(), but returns the Status rather than throwing.
+ */
+Decoder::Status Decoder::try_feed(const uint8_t *a, const uint8_t *b)
 {
     using S = State;
+    const uint8_t* const a0 = a;
+    auto offset_of = [this, a0] (const uint8_t* p) {
+			 return offset + (p - a0);
+		     };
 
     while (a!=b) {
 	const auto ch = *a;
@@ -115,40 +243,79 @@ void Decoder::feed(const uint8_t *a, const uint8_t *b)
 		state = S::FF;
 	    }
 	    else {
-		throw FalseStart {};
+		return fail(Status::FalseStart);
 	    }
 	    a++;
 	    break;
 
 	case S::Entropy:
-	    a = std::find(a, b, ff);
-	    if (a!=b) {
+	    a = scan(a, b);
+	    if (a==b) break;
+	    if (a+1==b) {
+		// can't tell yet if it's stuffing
+		state = S::EntropyFF;
+	    }
+	    else {
+		leave_entropy(offset_of(a));
 		state = S::FF;
+	    }
+	    a++;
+	    break;
+
+	case S::EntropyFF:
+	    if (ch==nil) {
+		state = S::Entropy;
 		a++;
 	    }
+	    else {
+		// the FF (in the previous feed) was a marker after all
+		leave_entropy(offset_of(a) - 1);
+		state = S::FF;
+	    }
 	    break;
 
 	case S::Segment:
 	    a = acc->feed(a, b);
-	    if (!acc->missing) state = S::Entropy;
+	    if (!acc->missing) {
+		state = after_segment();
+		enter_entropy(acc->marker, offset_of(a));
+	    }
 	    break;
 
 	case S::FF:
 	    if (ch==nil) {
-		if (v.empty()) throw FalseStart {};
+		if (views.empty()) return fail(Status::FalseStart);
 		state = S::Entropy;
 	    }
 	    else if (ch==ff) {
 		;
 	    }
 	    else if (standalone(ch)) {
-		acc->emit(ch);
+		acc->emit(ch, offset_of(a+1));
 		if (ch==marker::EOI) {
 		    state = S::Trailer;
 		}
 		else {
 		    state = S::Entropy;
+		    enter_entropy(ch, offset_of(a+1));
+		}
+	    }
+	    else if (b - a >= 3) {
+		// the usual case: marker and length in one go
+		acc->begin(ch);
+		acc->msb(a[1]);
+		if (!acc->lsb(a[2], offset_of(a+3))) {
+		    return fail(Status::IllegalLength);
+		}
+		a += 3;
+		if (!acc->missing) {
+		    state = after_segment();
+		    enter_entropy(acc->marker, offset_of(a));
+		}
+		else {
+		    state = S::Segment;
 		}
+		break;
 	    }
 	    else {
 		acc->begin(ch);
@@ -164,9 +331,12 @@ void Decoder::feed(const uint8_t *a, const uint8_t *b)
 	    break;
 
 	case S::FFmmnn:
-	    acc->lsb(ch);
+	    if (!acc->lsb(ch, offset_of(a+1))) {
+		return fail(Status::IllegalLength);
+	    }
 	    if (!acc->missing) {
-		state = S::Entropy;
+		state = after_segment();
+		enter_entropy(acc->marker, offset_of(a+1));
 	    }
 	    else {
 		state = S::Segment;
@@ -175,21 +345,197 @@ void Decoder::feed(const uint8_t *a, const uint8_t *b)
 	    break;
 
 	case S::Trailer:
+	case S::Done:
 	    a = b;
 	    break;
+
+	case S::Failed:
+	    return error;
 	}
     }
+
+    offset += b - a0;
+    return Status::Ok;
+}
+
+/**
+ * Remember 'status' as the reason the decoding failed, unless
+ * it already had.  Returns the reason.
+ */
+Decoder::Status Decoder::fail(Status status)
+{
+    if (state!=State::Failed) {
+	state = State::Failed;
+	error = status;
+    }
+    return error;
+}
+
+/**
+ * Throw the exception corresponding to 'status', if any.
+ */
+void Decoder::raise(Status status)
+{
+    switch (status) {
+    case Status::Ok: break;
+    case Status::IllegalLength: throw IllegalLength {};
+    case Status::Trailer: throw Trailer {};
+    case Status::FalseStart: throw FalseStart {};
+    }
+}
+
+/**
+ * True if there's no point in feeding more data: either EOI has
+ * been seen, (in Mode::Headers) the first SOS segment, or the
+ * decoding has failed.
+ */
+bool Decoder::done() const
+{
+    return state==State::Trailer || state==State::Done || state==State::Failed;
+}
+
+/**
+ * The number of octets the decoder knows it needs before anything
+ * interesting can happen: the rest of the segment it's in the middle
+ * of, or 0 if it doesn't know.  Just a hint for sizing the next read.
+ */
+size_t Decoder::wanted() const
+{
+    return state==State::Segment ? acc->missing : 0;
+}
+
+/**
+ * How much of the stream the decoder can do without right now: the
+ * rest of a segment it's in the middle of, but doesn't keep.  A
+ * caller which can seek may skip() that instead of reading and
+ * feeding it.
+ */
+size_t Decoder::skippable() const
+{
+    return state==State::Segment && !acc->copy ? acc->missing : 0;
+}
+
+/**
+ * Like feeding the next 'n' octets, but without them. 'n' has to be
+ * at most skippable().
+ */
+void Decoder::skip(size_t n)
+{
+    n = std::min(n, skippable());
+    if (!n) return;
+    acc->skip(n);
+    offset += n;
+    if (!acc->missing) {
+	state = after_segment();
+	enter_entropy(acc->marker, offset);
+    }
+}
+
+/**
+ * Start a stretch of entropy-encoded data after 'marker', at
+ * 'offset'.
+ */
+void Decoder::enter_entropy(unsigned marker, size_t offset)
+{
+    stretch = {marker, offset, 0};
+}
+
+/**
+ * End the current stretch of entropy-encoded data at 'offset'.
+ */
+void Decoder::leave_entropy(size_t offset)
+{
+    if (offset > stretch.offset) {
+	entropy.emplace_back(stretch.marker, stretch.offset,
+			     offset - stretch.offset);
+    }
+    stretch.offset = offset;
+}
+
+/**
+ * The state to enter after a complete segment: normally
+ * entropy-encoded data follows, but in Mode::Headers SOS marks the
+ * end of the interesting part.
+ */
+Decoder::State Decoder::after_segment() const
+{
+    if (mode==Mode::Headers && acc->marker==marker::SOS) return State::Done;
+    return State::Entropy;
 }
 
 std::vector<Segment>& Decoder::end()
+{
+    raise(try_end());
+    return v;
+}
+
+/**
+ * Like end(), but returns the Status rather than throwing.  The
+ * Segments are in 'v', as usual.
+ */
+Decoder::Status Decoder::try_end()
 {
     switch (state) {
-    case State::Trailer:
     case State::Entropy:
+	leave_entropy(offset);
+	break;
+    case State::Trailer:
+    case State::Done:
 	break;
+    case State::Failed:
+	return error;
     default:
-	throw Trailer {};
+	return fail(Status::Trailer);
     }
 
+    return Status::Ok;
+}
+
+/**
+ * The scans found by 'decoder', after end().  The DRI segments must
+ * have been kept (see Markers) for the restart intervals to be known;
+ * otherwise they are all 0.
+ */
+std::vector<Scan> jfif::scans(const Decoder& decoder)
+{
+    std::vector<Scan> v;
+    unsigned interval = 0;
+    auto dri = decoder.v.begin();
+    auto entropy = decoder.entropy.begin();
+
+    auto next_dri = [&dri, &decoder] () -> const Segment* {
+			while (dri!=decoder.v.end()) {
+			    const Segment& seg = *dri++;
+			    if (seg.marker==marker::DRI) return &seg;
+			}
+			return nullptr;
+		    };
+
+    // the chunk starting at 'offset'
+    auto chunk = [&entropy, &decoder] (unsigned marker, size_t offset) {
+		     View view {marker, offset, 0};
+		     while (entropy!=decoder.entropy.end() &&
+			    entropy->offset < offset) entropy++;
+		     if (entropy!=decoder.entropy.end() &&
+			 entropy->offset==offset) view.size = entropy->size;
+		     return view;
+		 };
+
+    for (const View& view : decoder.views) {
+	if (view.marker==marker::DRI) {
+	    const Segment* seg = next_dri();
+	    if (seg && seg->v.size()==2) interval = seg->v[0] << 8 | seg->v[1];
+	}
+	else if (view.marker==marker::SOS) {
+	    Scan scan;
+	    scan.sos = view;
+	    scan.interval = interval;
+	    scan.chunks.push_back(chunk(view.marker, view.offset + view.size));
+	    v.push_back(scan);
+	}
+	else if (rst(view.marker) && !v.empty()) {
+	    v.back().chunks.push_back(chunk(view.marker, view.offset));
+	}
+    }
     return v;
 }
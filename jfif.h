@@ -27,6 +27,11 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <bitset>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <algorithm>
 
 namespace jfif {
 
@@ -81,6 +86,106 @@ namespace jfif {
 	return marker < other.marker;
     }
 
+    /**
+     * A segment which isn't copied anywhere: the marker, and the
+     * offset and size of its data in the decoded stream.  If all of
+     * that stream is still in memory (e.g. a memory-mapped file) you
+     * can use the data where it is.
+     *
+     * For standalone segments, 'offset' is just past the marker and
+     * 'size' is 0.
+     */
+    struct View {
+	View() = default;
+	View(unsigned marker, size_t offset, size_t size)
+	    : marker(marker),
+	      offset(offset),
+	      size(size)
+	{}
+	bool operator== (const View&) const;
+	uint8_t marker = 0;
+	size_t offset = 0;
+	size_t size = 0;
+
+	const uint8_t* begin(const uint8_t* base) const { return base + offset; }
+	const uint8_t* end(const uint8_t* base) const { return begin(base) + size; }
+	bool starts(const uint8_t* base, const std::string& id) const;
+    };
+
+    inline bool View::operator== (const View& other) const
+    {
+	return marker==other.marker && offset==other.offset && size==other.size;
+    }
+
+    /**
+     * True if the data (found at 'base') starts with identifier 'id'.
+     */
+    inline bool View::starts(const uint8_t* base, const std::string& id) const
+    {
+	if (size < id.size()) return false;
+	return std::equal(id.begin(), id.end(), begin(base));
+    }
+
+    /**
+     * The identifiers at the start of the data of some APPn segments.
+     * Especially APP1 is used for different things, and you have to
+     * look at the identifier to see which.
+     */
+    namespace identifier {
+	extern const std::string Exif;
+	extern const std::string XMP;
+    }
+
+    /**
+     * A set of markers; used to tell a Decoder which segments you
+     * want the data of.  A marker can also come with an identifier,
+     * meaning you only want those segments whose data starts with it.
+     */
+    class Markers {
+    public:
+	Markers(std::initializer_list<unsigned> markers);
+	static Markers all();
+	Markers& add(unsigned marker, const std::string& id);
+
+	bool has(unsigned marker) const { return set[marker & 0xff]; }
+	const std::string* id(unsigned marker) const;
+
+    private:
+	std::bitset<256> set;
+	std::vector<std::pair<unsigned, std::string>> ids;
+    };
+
+    inline Markers::Markers(std::initializer_list<unsigned> markers)
+    {
+	for (unsigned m : markers) set[m & 0xff] = true;
+    }
+
+    inline Markers& Markers::add(unsigned marker, const std::string& id)
+    {
+	set[marker & 0xff] = true;
+	ids.emplace_back(marker & 0xff, id);
+	return *this;
+    }
+
+    /**
+     * The identifier wanted for 'marker', or null if any segment
+     * with that marker will do.
+     */
+    inline const std::string* Markers::id(unsigned marker) const
+    {
+	for (const auto& id : ids) {
+	    if (id.first==marker) return &id.second;
+	}
+	return nullptr;
+    }
+
+    inline Markers Markers::all()
+    {
+	Markers markers {};
+	markers.set.set();
+	return markers;
+    }
+
     struct Accumulator;
 
     /**
@@ -95,10 +200,56 @@ namespace jfif {
      *
      * The decoder gets fed by a sequence of feed() terminated by
      * end(). Throws Decoder::Error subclasses on decoding error.
+     *
+     * There's also a non-throwing way to do the same thing:
+     * try_feed() and try_end() return a Status instead, and the
+     * decoder remembers the first failure.  A failed decoder is
+     * done(), and the Views and Segments found before the failure are
+     * still there.  Exceptions are expensive when most of the files
+     * you decode are broken.
+     *
+     * In Mode::Headers, the decoder is done at the end of the first
+     * SOS segment: everything after that is entropy-encoded data,
+     * more of the same and EOI, and it's only needed if you want to
+     * validate the whole file.  Callers interested in metadata should
+     * stop feeding once done() says so.
+     *
+     * Every segment gets a View in 'views', but only the segments
+     * with the markers in 'keep' are copied into 'v'.  The data of
+     * the others is skipped, which is cheap.  If you don't keep any
+     * segments at all, the Views are all you have; that's useful for
+     * data which is all in memory anyway.
+     *
+     * If 'keep' wants a segment only if it has a certain identifier,
+     * the decoder buffers just enough of the data to find out.  So
+     * e.g. an XMP APP1 can be skipped while looking for the Exif one.
+     *
+     * wanted() tells how much data the decoder could use right now,
+     * so the caller can e.g. read a whole segment in one go.
+     *
+     * The stretches of entropy-encoded data get Views of their own,
+     * in 'entropy'. Their marker is the one they follow: normally SOS
+     * or an RSTn.  Empty stretches aren't recorded, and FF padding
+     * before a marker is not part of the data.
+     *
+     * The data of a segment which isn't kept doesn't have to be fed
+     * at all: skippable() says how much of it remains, and a caller
+     * reading from something seekable can skip() it and continue
+     * reading after it.  Then only the Views are recorded, and you
+     * can read the data of a segment later, if you need it.
+     *
+     * A Decoder can be reset() and reused for another stream, which
+     * saves memory allocations when decoding many files.
      */
     class Decoder {
     public:
-	Decoder();
+	enum class Mode {
+	    Full,
+	    Headers
+	};
+
+	explicit Decoder(Mode mode = Mode::Full,
+			 const Markers& keep = Markers::all());
 	~Decoder();
 	Decoder(const Decoder&) = delete;
 	Decoder& operator= (const Decoder&) = delete;
@@ -109,23 +260,76 @@ namespace jfif {
 	class Empty: public Error {};
 	class FalseStart: public Error {};
 
+	/**
+	 * The non-throwing version of the errors above.
+	 */
+	enum class Status {
+	    Ok,
+	    IllegalLength,
+	    Trailer,
+	    FalseStart
+	};
+
+	void reset();
 	void feed(const uint8_t *a, const uint8_t *b);
+	Status try_feed(const uint8_t *a, const uint8_t *b);
+	Status status() const { return error; }
+	bool done() const;
+	size_t wanted() const;
+	size_t skippable() const;
+	void skip(size_t n);
 	std::vector<Segment>& end();
+	Status try_end();
 
 	std::vector<Segment> v;
+	std::vector<View> views;
+	std::vector<View> entropy;
 
 	enum class State {
 	    Start,
 	    Entropy,
+	    EntropyFF,
 	    Segment,
 	    FF, FFmm, FFmmnn,
-	    Trailer
+	    Trailer,
+	    Done,
+	    Failed
 	};
 
     private:
 	std::unique_ptr<Accumulator> acc;
+	const Mode mode;
 	State state;
+	Status error = Status::Ok;
+	size_t offset = 0;
+	View stretch;
+
+	Status fail(Status status);
+	static void raise(Status status);
+	State after_segment() const;
+	void enter_entropy(unsigned marker, size_t offset);
+	void leave_entropy(size_t offset);
     };
+
+    /**
+     * A scan (the data following an SOS segment) split at its restart
+     * markers, as found by a Decoder: the SOS segment, the restart
+     * interval in MCUs in effect for it (0 if none) and its chunks of
+     * entropy-encoded data; the first after the SOS and then one after
+     * each RSTn.  Since the DC prediction etc. is reset at each RSTn,
+     * the chunks can be decoded independently of each other.
+     *
+     * The chunks are Views, with SOS or RSTn as the marker.  A chunk
+     * can be empty, but it's still there, so that chunk n always
+     * starts at MCU n * interval.
+     */
+    struct Scan {
+	View sos;
+	unsigned interval = 0;
+	std::vector<View> chunks;
+    };
+
+    std::vector<Scan> scans(const Decoder& decoder);
 }
 
 #endif
@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#include "mapping.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+Mapping::Mapping(const int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st)==-1) return;
+    if (!S_ISREG(st.st_mode)) return;
+
+    if (st.st_size) {
+	void* const p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (p==MAP_FAILED) return;
+	a = static_cast<const uint8_t*>(p);
+	n = st.st_size;
+    }
+    ok = true;
+}
+
+Mapping::~Mapping()
+{
+    if (n) munmap(const_cast<uint8_t*>(a), n);
+}
@@ -0,0 +1,39 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_MAPPING_H
+#define OLYMP_MAPPING_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * A read-only memory mapping of all of an open file, for looking at
+ * it without copying it.
+ *
+ * If the file cannot be mapped (it's not a regular file, or mmap(2)
+ * fails for some other reason) the Mapping is invalid, and you have
+ * to read(2) the file instead.  An empty file is valid, but empty.
+ */
+class Mapping {
+public:
+    explicit Mapping(int fd);
+    ~Mapping();
+    Mapping(const Mapping&) = delete;
+    Mapping& operator= (const Mapping&) = delete;
+
+    bool valid() const { return ok; }
+    const uint8_t* begin() const { return a; }
+    const uint8_t* end() const { return a + n; }
+    size_t size() const { return n; }
+
+private:
+    bool ok = false;
+    const uint8_t* a = nullptr;
+    size_t n = 0;
+};
+
+#endif
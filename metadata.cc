@@ -8,6 +8,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <cctype>
 
 Metadata::Metadata(const Serial& nnnn,
 		   const exif::DateTimeOriginal ts,
@@ -17,23 +18,56 @@ Metadata::Metadata(const Serial& nnnn,
       coord {coord}
 {}
 
+/**
+ * The Metadata in the Exif data 'tiff': one walk over the Exif IFD
+ * and one over the GPS IFD.
+ */
+Metadata::Metadata(const Serial& nnnn, const tiff::File& tiff)
+    : nnnn {nnnn},
+      ts {tiff},
+      coord {tiff}
+{}
+
 /**
  * The JPG image file name formed by the date and serial
  * number.
  */
 std::string Metadata::filename() const
+{
+    return filename(".jpg");
+}
+
+/**
+ * Like filename(), but with extension 'ext'.
+ */
+std::string Metadata::filename(const std::string& ext) const
 {
     std::ostringstream oss;
-    oss << ts.date() << '_' << nnnn << ".jpg";
+    oss << ts.date() << '_' << nnnn << ext;
     return oss.str();
 }
 
+namespace {
+
+    bool jpeg(const std::string& ext)
+    {
+	std::string s = ext;
+	for (char& ch : s) ch = std::tolower(ch);
+	return s=="" || s==".jpg" || s==".jpeg";
+    }
+}
+
 /**
- * This file, as a neighbor of 'path'.
+ * This file, as a neighbor of 'path'.  A JPEG file gets the
+ * filename(); any other file (i.e. a raw file) keeps its extension,
+ * so that e.g. P1010001.ORF doesn't take the name meant for
+ * P1010001.JPG.
  */
 std::string Metadata::neighbor_of(const std::string& path) const
 {
-    return neighbour(path, filename());
+    const std::string ext = extension(path);
+    if (jpeg(ext)) return neighbour(path, filename());
+    return neighbour(path, filename(ext));
 }
 
 /**
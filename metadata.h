@@ -23,10 +23,14 @@ public:
     Metadata(const Serial& nnnn,
 	     const exif::DateTimeOriginal ts,
 	     const wgs84::Coordinate coord);
+    Metadata(const Serial& nnnn, const tiff::File& tiff);
 
     bool valid() const { return ts.valid(); }
+    const exif::DateTimeOriginal& timestamp() const { return ts; }
+    const wgs84::Coordinate& coordinate() const { return coord; }
 
     std::string filename() const;
+    std::string filename(const std::string& ext) const;
     std::string neighbor_of(const std::string& path) const;
 
     bool near(const Metadata& other) const;
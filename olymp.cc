@@ -20,10 +20,14 @@
  */
 #include <string>
 #include <vector>
+#include <deque>
 #include <algorithm>
 #include <memory>
 #include <iostream>
+#include <fstream>
 #include <cstring>
+#include <exception>
+#include <functional>
 
 #include <getopt.h>
 #include <unistd.h>
@@ -32,10 +36,17 @@
 #include <fcntl.h>
 
 #include "jfif.h"
+#include "fileio.h"
+#include "mapping.h"
+#include "uring.h"
+#include "walk.h"
+#include "cache.h"
 #include "tiff/tiff.h"
+#include "tiff/optional.h"
 #include "exif.h"
 #include "metadata.h"
 #include "cluster.h"
+#include "ordered.h"
 
 #include "wgs84.h"
 #include "sweref99.h"
@@ -44,103 +55,424 @@
 
 namespace {
 
-    struct IOError {};
+    /**
+     * The segments wanted when looking for Exif data: APP1 segments
+     * with the Exif identifier, but not e.g. the ones with XMP data.
+     */
+    jfif::Markers exif_app1()
+    {
+	return jfif::Markers {}.add(jfif::marker::APP1,
+				    jfif::identifier::Exif);
+    }
 
     /**
-     * Minimal wrapper for the opened-for-reading fd used here.
+     * A Decoder for Exif APP1 segments, reset and ready to use.
+     * There's one per thread, reused from file to file, so that in
+     * the steady state decoding allocates no memory.  It's only good
+     * until the next call in the same thread.
      */
-    class Fd {
-    public:
-	explicit Fd(const std::string& path)
-	    : fd {open(path.c_str(), O_RDONLY)}
-	{
-	    if (fd==-1) throw IOError {};
-	}
-	~Fd() { close(fd); }
+    jfif::Decoder& exif_decoder()
+    {
+	thread_local jfif::Decoder decoder {jfif::Decoder::Mode::Headers,
+					    exif_app1()};
+	decoder.reset();
+	return decoder;
+    }
 
-	ssize_t read(void *buf, size_t count) const
-	{
-	    return ::read(fd, buf, count);
-	}
+    /**
+     * Like exif_decoder(), but for a Decoder which only produces
+     * Views.
+     */
+    jfif::Decoder& view_decoder()
+    {
+	thread_local jfif::Decoder decoder {jfif::Decoder::Mode::Headers, {}};
+	decoder.reset();
+	return decoder;
+    }
 
-    private:
-	const int fd;
-    };
+    /**
+     * Where we expect the Exif APP1 to be: near the start of the file,
+     * and a segment cannot be larger than 64K.
+     */
+    constexpr off_t header_window = 72*1024;
 
-    struct NoApp1 {};
+    /**
+     * How to read a file for its Exif APP1: in small chunks, and
+     * no further than to the APP1.
+     */
+    const Reading exif_reading {8*1024, header_window,
+				[] (const jfif::Decoder& decoder) {
+				    return !decoder.v.empty();
+				}};
 
     /**
-     * The JFIF APP1 segment found in open file 'fd'. May throw.
+     * The decoder which has looked for the Exif JFIF APP1 segment in
+     * open file 'fd', whose 'head' has already been read.  The APP1
+     * is the first of its segments, if it found one and didn't fail.
+     * Only throws on I/O errors.
+     *
+     * Reads no further than to the first SOS segment, since there
+     * are no interesting segments after that, and doesn't bother
+     * buffering segments other than the Exif APP1.  Nor reading them,
+     * past the first read: the rest of e.g. a large XMP APP1 or an
+     * APP2 with a preview image is skipped.
+     *
+     * This is this thread's exif_decoder(), and is only good until
+     * the next call.
      */
-    jfif::Segment app1_of(const Fd& fd)
+    const jfif::Decoder& app1_of(const Fd& fd,
+				 const std::vector<uint8_t>& head)
     {
-	jfif::Decoder decoder;
-	uint8_t buf[8*1024];
+	jfif::Decoder& decoder = exif_decoder();
+	feed(decoder, fd, exif_reading, head);
+	if (decoder.v.empty()) decoder.try_end();
+	return decoder;
+    }
 
-	auto is_app1 = [] (const jfif::Segment& seg) {
-			   return seg.marker == jfif::marker::APP1;
+    /**
+     * The Exif APP1 data in 'map', as found by 'decoder', or the empty
+     * range.
+     */
+    tiff::Range app1_in(const jfif::Decoder& decoder, const Mapping& map)
+    {
+	auto is_app1 = [&map] (const jfif::View& view) {
+			   return view.marker == jfif::marker::APP1
+			       && view.starts(map.begin(), jfif::identifier::Exif);
 		       };
 
-	while (1) {
-	    auto res = fd.read(buf, sizeof buf);
-	    if (res==-1) throw IOError {};
-	    if (res==0) break;
+	auto it = std::find_if(begin(decoder.views), end(decoder.views), is_app1);
+	if (it==end(decoder.views)) return {};
+	return {it->begin(map.begin()), it->end(map.begin())};
+    }
 
-	    decoder.feed(buf, buf+res);
-	    auto it = std::find_if(begin(decoder.v), end(decoder.v), is_app1);
-	    if (it!=end(decoder.v)) return *it;
-	}
-	decoder.end();
-	auto it = std::find_if(begin(decoder.v), end(decoder.v), is_app1);
-	if (it!=end(decoder.v)) return *it;
-	throw NoApp1 {};
+    /**
+     * Like app1_of(fd), but for a file mapped into memory. The
+     * decoder only has Views, and the APP1 data stays in 'map';
+     * app1_in() finds it.
+     */
+    const jfif::Decoder& app1_of(const Mapping& map)
+    {
+	jfif::Decoder& decoder = view_decoder();
+	decoder.try_feed(map.begin(), map.end());
+	if (!app1_in(decoder, map).size()) decoder.try_end();
+	return decoder;
     }
 
     /**
      * A bit like 'mv -i'.
      */
-    bool mv_i(const std::string& from,
+    bool mv_i(const Entry& from,
 	      const Metadata& meta)
     {
 	/* Use link(2) instead of rename(2) since it's important to
 	 * fail rather than destroy existing files.
 	 */
-	const auto to = meta.neighbor_of(from);
-	if (to==from) return true;
-	int err = link(from.c_str(), to.c_str());
+	const auto to = meta.neighbor_of(from.name);
+	if (to==from.name) return true;
+	const int dir = from.at();
+	int err = linkat(dir, from.name.c_str(), dir, to.c_str(), 0);
 	if (err) return false;
 
-	err = unlink(from.c_str());
+	err = unlinkat(dir, from.name.c_str(), 0);
 	return !err;
     }
 
     bool not_near(const Metadata&, const Metadata&) { return false; }
 
+    /**
+     * What examining a file results in: its Metadata, or else an
+     * error message.
+     */
+    struct Outcome {
+	std::unique_ptr<const Metadata> meta;
+	std::string error;
+	Cost cost;
+	optional<Cache::Key> key;
+    };
+
+    Outcome failed(const char* error)
+    {
+	Outcome outcome;
+	outcome.error = error;
+	return outcome;
+    }
+
+    /**
+     * The Outcome for 'file', as produced by f(serial number).
+     * Exceptions from f are turned into error messages.
+     *
+     * The expected failures (a file which isn't JPEG, or has no Exif
+     * data, or is corrupt) don't come as exceptions, but as an
+     * Outcome with an error message, since exceptions are expensive
+     * when most files are broken.
+     */
+    template <class F>
+    Outcome attempt(const Entry& file, F f)
+    {
+	Outcome outcome;
+	std::string& error = outcome.error;
+
+	const Serial nnnn = serial(file.name);
+	if (!nnnn.valid()) {
+	    error = "no serial number in file name";
+	    return outcome;
+	}
+
+	try {
+	    return f(nnnn);
+	}
+	catch (const IOError& e) {
+	    error = std::strerror(e.err);
+	}
+	catch (const tiff::Error&) {
+	    error = "corrupt EXIF data structure";
+	}
+
+	return outcome;
+    }
+
+    /**
+     * The Outcome for a file with serial number 'nnnn' and Exif data
+     * 'tiff'.
+     */
+    Outcome outcome_of(const Serial& nnnn, const tiff::File& tiff)
+    {
+	Outcome outcome;
+	const Metadata meta {nnnn, tiff};
+	if (!meta.valid()) {
+	    outcome.error = "no valid timestamp in EXIF data";
+	}
+	else {
+	    outcome.meta.reset(new Metadata {meta});
+	}
+	return outcome;
+    }
+
+    /**
+     * The Outcome for a file with serial number 'nnnn' and Exif APP1
+     * 'app1'.
+     */
+    Outcome outcome_of(const Serial& nnnn, const tiff::Range& app1)
+    {
+	tiff::Status status;
+	const tiff::File tiff {app1, status};
+	if (status!=tiff::Status::Ok) return failed("corrupt EXIF data structure");
+	return outcome_of(nnnn, tiff);
+    }
+
+    /**
+     * The Outcome for a raw TIFF file with serial number 'nnnn' and
+     * contents 'data'.
+     */
+    Outcome outcome_of(const Serial& nnnn, tiff::File::Raw raw,
+		       const tiff::Range& data)
+    {
+	tiff::Status status;
+	const tiff::File tiff {raw, data, status};
+	if (status!=tiff::Status::Ok) return failed("corrupt EXIF data structure");
+	return outcome_of(nnnn, tiff);
+    }
+
+    /**
+     * The Outcome for a JPEG file with serial number 'nnnn', given the
+     * 'decoder' which looked for its Exif APP1, and that APP1.
+     */
+    Outcome outcome_of(const Serial& nnnn, const jfif::Decoder& decoder,
+		       const tiff::Range& app1)
+    {
+	if (decoder.status()!=jfif::Decoder::Status::Ok) {
+	    return failed("cannot decode as JPEG");
+	}
+	if (!app1.size()) return failed("no EXIF data in file");
+	return outcome_of(nnnn, app1);
+    }
+
+    /**
+     * Like the above, for a decoder which kept the APP1 segment.
+     */
+    Outcome outcome_of(const Serial& nnnn, const jfif::Decoder& decoder)
+    {
+	if (decoder.v.empty()) return outcome_of(nnnn, decoder, tiff::Range {});
+	return outcome_of(nnnn, decoder, tiff::Range {decoder.v.front().v});
+    }
+
+    /**
+     * The Outcome for a file which isn't of a Format we can examine.
+     * These are to be expected in a mixed directory, so there's no
+     * exception.
+     */
+    Outcome rejected(Format format)
+    {
+	Outcome outcome;
+	if (format==Format::Unknown) {
+	    outcome.error = "unknown file format";
+	}
+	else {
+	    outcome.error = std::string("unsupported file format: ")
+		+ name_of(format);
+	}
+	return outcome;
+    }
+
+    /**
+     * All of open file 'fd', read into 'buf'. May throw.
+     */
+    void contents_of(const Fd& fd, std::vector<uint8_t>& buf)
+    {
+	buf.clear();
+	while (true) {
+	    const size_t n = buf.size();
+	    buf.resize(n + 64*1024);
+	    auto res = fd.pread(buf.data() + n, buf.size() - n, n);
+	    if (res==-1) throw IOError {};
+	    buf.resize(n + res);
+	    if (res==0) break;
+	}
+    }
+
+    /**
+     * The Outcome for a raw TIFF file with serial number 'nnnn', in
+     * open file 'fd'.  The Exif data can be anywhere in such a file,
+     * so it's mapped if possible, or else read in full.
+     */
+    Outcome raw_outcome_of(const Serial& nnnn, const Fd& fd)
+    {
+	const tiff::File::Raw raw;
+	const auto map = mapping_of(fd);
+	if (map) {
+	    return outcome_of(nnnn, raw, {map->begin(), map->end()});
+	}
+	thread_local std::vector<uint8_t> buf;
+	contents_of(fd, buf);
+	return outcome_of(nnnn, raw, tiff::Range {buf});
+    }
+
+    /**
+     * The Outcome for a file with serial number 'nnnn', mapped into
+     * memory as 'map'.
+     */
+    Outcome outcome_of(const Serial& nnnn, const Mapping& map)
+    {
+	const Format format = sniff(map.begin(), map.end());
+	switch (format) {
+	case Format::Jpeg: {
+	    const jfif::Decoder& decoder = app1_of(map);
+	    return outcome_of(nnnn, decoder, app1_in(decoder, map));
+	}
+	case Format::Tiff:
+	    return outcome_of(nnnn, tiff::File::Raw {}, {map.begin(), map.end()});
+	default:
+	    return rejected(format);
+	}
+    }
+
+    /**
+     * The Outcome for a file with serial number 'nnnn', in open file
+     * 'fd' which is to be read.  A single read tells what it is, and
+     * only if it's something we can handle is there any more I/O.
+     */
+    Outcome outcome_of(const Serial& nnnn, const Fd& fd)
+    {
+	thread_local std::vector<uint8_t> head;
+	const Format format = head_of(fd, exif_reading, head);
+	switch (format) {
+	case Format::Jpeg:
+	    return outcome_of(nnnn, app1_of(fd, head));
+	case Format::Tiff:
+	    return raw_outcome_of(nnnn, fd);
+	default:
+	    return rejected(format);
+	}
+    }
+
+    /**
+     * Where the file names come from: the command line, followed by a
+     * list read from a stream (if any), one name per line or
+     * NUL-terminated.  The list is read as the names are needed, so it
+     * can be as long as you like without using more memory.
+     */
+    class Names {
+    public:
+	Names(char** a, char** b) : a{a}, b{b} {}
+	void list(std::istream& is, char delimiter);
+	bool next(std::string& name);
+
+    private:
+	char** a;
+	char** const b;
+	std::istream* is = nullptr;
+	char delimiter = '\n';
+    };
+
+    void Names::list(std::istream& is, char delimiter)
+    {
+	this->is = &is;
+	this->delimiter = delimiter;
+    }
+
+    /**
+     * Get the next name, or return false if there are no more.
+     * Empty lines in the list are ignored.
+     */
+    bool Names::next(std::string& name)
+    {
+	if (a!=b) {
+	    name = *a++;
+	    return true;
+	}
+	while (is && std::getline(*is, name, delimiter)) {
+	    if (!name.empty()) return true;
+	}
+	return false;
+    }
+
     /**
      * Investigate 'files', a sequence of file names, and print a
-     * better name, and date/time stamp, to 'out'.
+     * better name, and date/time stamp, to 'out'.  If 'recursive' is
+     * set, the names may also be directories, and all files in those
+     * trees are investigated.
      *
      * If 'rename' is set, also try to rename them accordingly.
      * Whines to 'err' if something goes wrong, and also sets a
      * non-zero exit code in 'status'.
+     *
+     * Up to 'jobs' files are examined in parallel, but the printing,
+     * renaming and whining happens in order, as if they weren't.
+     * With Io::Uring, all of it happens in one thread, but the I/O
+     * for many files is in flight at once.
      */
     class Olymp {
     public:
 	Olymp(std::ostream& out, std::ostream& err,
 	      bool rename,
 	      bool prefer_sweref,
-	      bool form_clusters);
-	void run(const std::vector<std::string>& files);
+	      bool form_clusters,
+	      Io io,
+	      unsigned jobs,
+	      bool stats,
+	      bool recursive,
+	      const std::string& cache);
+	void run(Names& files);
 	int status = 0;
 
     private:
-	bool runf(Cluster<Metadata>& cluster,
-		  const std::string& file);
+	void feed(Names& files,
+		  const std::function<void(const Entry&)>& push);
+	Outcome cached(const Entry& file, const Serial& nnnn) const;
+	Outcome examine(const Entry& file) const;
+	bool report(Cluster<Metadata>& cluster,
+		    const Entry& file,
+		    const Outcome& outcome);
 	void render(const std::vector<Metadata>& v);
 
 	std::ostream& os;
 	std::ostream& err;
 	const bool rename;
+	const Io io;
+	const unsigned jobs;
+	const bool stats;
+	const bool recursive;
+	const std::unique_ptr<Cache> cache;
 	const std::unique_ptr<Transform> transform;
 	std::function<bool(const Metadata&, const Metadata&)> near;
     };
@@ -148,75 +480,210 @@ namespace {
     Olymp::Olymp(std::ostream& out, std::ostream& err,
 		 bool rename,
 		 bool prefer_sweref,
-		 bool form_clusters)
+		 bool form_clusters,
+		 Io io,
+		 unsigned jobs,
+		 bool stats,
+		 bool recursive,
+		 const std::string& cache)
 	: os{out},
 	  err{err},
 	  rename{rename},
+	  io{io},
+	  jobs{jobs},
+	  stats{stats},
+	  recursive{recursive},
+	  cache{cache.empty() ? nullptr : new Cache {cache}},
 	  transform{prefer_sweref? new Transform: nullptr},
 	  near{form_clusters? ::near: not_near}
     {}
 
-    void Olymp::run(const std::vector<std::string>& files)
+    void Olymp::run(Names& files)
     {
 	Cluster<Metadata> cluster(near);
 
-	for (const auto& file: files) {
-	    if(!runf(cluster, file)) status = 1;
+	auto report = [this, &cluster] (const Entry& file,
+					 const Outcome& outcome) {
+			  if(!this->report(cluster, file, outcome)) status = 1;
+		      };
+
+	std::unique_ptr<Uring> ring;
+	if (io==Io::Uring) {
+	    ring.reset(new Uring {64});
+	    if (!ring->valid()) ring.reset();
+	}
+
+	if (ring) {
+	    // the cache lookups, for each file in the Batch
+	    std::deque<Outcome> hits;
+
+	    auto sink = [&report, &hits] (const Entry& file,
+					  Format format,
+					  const jfif::Decoder& decoder,
+					  std::exception_ptr error,
+					  const Cost& cost) {
+			    Outcome hit = std::move(hits.front());
+			    hits.pop_front();
+			    if (hit.meta) return report(file, hit);
+
+			    // raw files are examined here and now
+			    Cost raw;
+			    auto f = [&] (const Serial& nnnn) {
+					 if (error) std::rethrow_exception(error);
+					 if (format==Format::Tiff) {
+					     const Fd fd {file, raw};
+					     return raw_outcome_of(nnnn, fd);
+					 }
+					 if (format!=Format::Jpeg) return rejected(format);
+					 return outcome_of(nnnn, decoder);
+				     };
+			    Outcome outcome = attempt(file, f);
+			    outcome.cost = cost;
+			    outcome.cost.calls += hit.cost.calls + raw.calls;
+			    outcome.cost.bytes += raw.bytes;
+			    outcome.key = hit.key;
+			    report(file, outcome);
+			};
+	    Batch batch {*ring,
+			 jfif::Decoder::Mode::Headers, exif_app1(),
+			 exif_reading,
+			 sink};
+
+	    try {
+		feed(files, [this, &batch, &hits] (const Entry& file) {
+				const Serial nnnn = serial(file.name);
+				hits.push_back(nnnn.valid() ? cached(file, nnnn)
+							    : Outcome {});
+				batch.push(file, nnnn.valid() && !hits.back().meta);
+			    });
+		batch.end();
+	    }
+	    catch (const IOError& e) {
+		err << "error: io_uring: " << std::strerror(e.err) << '\n';
+		status = 1;
+	    }
+	}
+	else {
+	    auto examine = [this] (const Entry& file) {
+			       return this->examine(file);
+			   };
+	    Ordered<Entry, Outcome> pool {jobs, examine, report};
+
+	    feed(files, [&pool] (const Entry& file) { pool.push(file); });
+	    pool.end();
 	}
 
 	render(cluster.end());
+
+	if (cache && !cache->save()) {
+	    err << "error: cannot save cache: " << std::strerror(errno) << '\n';
+	    status = 1;
+	}
+    }
+
+    /**
+     * Pass the Entries for 'files' to 'push'; walking them as trees
+     * if we're recursive.  Directories which cannot be read are
+     * complained about here and now, rather than in order.
+     */
+    void Olymp::feed(Names& files,
+		     const std::function<void(const Entry&)>& push)
+    {
+	auto error = [this] (const std::string& path, int errnum) {
+			 err << path << ": error: " << std::strerror(errnum) << '\n';
+			 status = 1;
+		     };
+
+	std::string file;
+	while (files.next(file)) {
+	    if (recursive) {
+		walk(file, push, error);
+	    }
+	    else {
+		push(Entry {file});
+	    }
+	}
     }
 
-    bool Olymp::runf(Cluster<Metadata>& cluster,
-		     const std::string& file)
+    /**
+     * The Metadata for 'file', or why there is none.  This part only
+     * looks at the file, so it can run in parallel with itself.
+     */
+    Outcome Olymp::examine(const Entry& file) const
+    {
+	Cost cost;
+	optional<Cache::Key> key;
+	auto f = [this, &file, &cost, &key] (const Serial& nnnn) {
+		     Outcome hit = cached(file, nnnn);
+		     cost = hit.cost;
+		     key = hit.key;
+		     if (hit.meta) return hit;
+
+		     const Fd fd {file, cost};
+		     const auto map = io==Io::Mmap ? mapping_of(fd) : nullptr;
+		     if (map) return outcome_of(nnnn, *map);
+		     return outcome_of(nnnn, fd);
+		 };
+	Outcome outcome = attempt(file, f);
+	outcome.cost = cost;
+	outcome.key = key;
+	return outcome;
+    }
+
+    /**
+     * The Outcome for 'file' according to the cache: with Metadata if
+     * it's there and still valid, otherwise with the Key to store it
+     * under once it's known.  Costs a single stat(2), if that.
+     */
+    Outcome Olymp::cached(const Entry& file, const Serial& nnnn) const
+    {
+	Outcome outcome;
+	if (!cache) return outcome;
+
+	struct stat st;
+	outcome.cost.calls++;
+	if (fstatat(file.at(), file.name.c_str(), &st, 0)) return outcome;
+	if (!S_ISREG(st.st_mode)) return outcome;
+
+	const Cache::Key key {st};
+	outcome.meta = cache->find(key, nnnn);
+	if (!outcome.meta) outcome.key = key;
+	return outcome;
+    }
+
+    /**
+     * Print and maybe rename 'file' according to what examine()
+     * found, or whine. Returns false on failure.
+     */
+    bool Olymp::report(Cluster<Metadata>& cluster,
+		       const Entry& file,
+		       const Outcome& outcome)
     {
 	auto errfile = [&] () -> std::ostream& {
-			   err << file << ": error: ";
+			   err << file.path() << ": error: ";
 			   return err;
 		       };
 
-	const Serial nnnn = serial(file);
-	if (!nnnn.valid()) {
-	    errfile() << "no serial number in file name\n";
-	    return false;
+	if (stats) {
+	    err << file.path() << ": " << outcome.cost.calls << " syscalls, "
+		<< outcome.cost.bytes << " bytes\n";
 	}
 
-	try {
-	    const Fd fd {file};
-	    const auto app1 = app1_of(fd);
-	    const tiff::File tiff {app1.v};
-
-	    const Metadata meta {nnnn,
-				 exif::DateTimeOriginal {tiff},
-				 wgs84::Coordinate {tiff}};
-	    if (!meta.valid()) {
-		errfile() << "no valid timestamp in EXIF data\n";
-		return false;
-	    }
-
-	    render(cluster.add(meta));
+	if (!outcome.meta) {
+	    errfile() << outcome.error << '\n';
+	    return false;
+	}
+	const Metadata& meta = *outcome.meta;
+	if (cache && outcome.key) cache->insert(*outcome.key, meta);
 
-	    if (rename && !mv_i(file, meta)) {
-		errfile() << "cannot rename: " << std::strerror(errno) << '\n';
-		return false;
-	    }
+	render(cluster.add(meta));
 
-	    return true;
-	}
-	catch (const jfif::Decoder::Error&) {
-	    errfile() << "cannot decode as JPEG\n";
-	}
-	catch (const IOError&) {
-	    errfile() << std::strerror(errno) << '\n';
-	}
-	catch (const NoApp1&) {
-	    errfile() << "no EXIF data in file\n";
-	}
-	catch (const tiff::Error&) {
-	    errfile() << "corrupt EXIF data structure\n";
+	if (rename && !mv_i(file, meta)) {
+	    errfile() << "cannot rename: " << std::strerror(errno) << '\n';
+	    return false;
 	}
 
-	return false;
+	return true;
     }
 
     void Olymp::render(const std::vector<Metadata>& v)
@@ -231,13 +698,19 @@ int main(int argc, char ** argv)
 {
     const std::string prog = argv[0] ? argv[0] : "olymp";
     const std::string usage = std::string("usage: ")
-	+ prog + " [-eMW] file ...\n"
+	+ prog + " [-eMWr] [-j jobs] [--io=read|mmap|uring] [--stats]\n"
+	"       " + std::string(prog.size(), ' ')
+	+ " [--cache=file] [--files-from=file [-0]] file ...\n"
 	"       "
 	+ prog + " --help\n"
 	"       "
 	+ prog + " --version";
-    const char optstring[] = "eMW";
+    const char optstring[] = "eMWr0j:";
     const struct option long_options[] = {
+	{"io", 1, 0, 'I'},
+	{"stats", 0, 0, 'S'},
+	{"cache", 1, 0, 'C'},
+	{"files-from", 1, 0, 'F'},
 	{"help", 0, 0, 'H'},
 	{"version", 0, 0, 'V'},
 	{0, 0, 0, 0}
@@ -249,6 +722,13 @@ int main(int argc, char ** argv)
     bool rename = false;
     bool prefer_sweref = true;
     bool form_clusters = true;
+    Io io = Io::Read;
+    unsigned jobs = 1;
+    bool stats = false;
+    bool recursive = false;
+    std::string cache;
+    std::string files_from;
+    char delimiter = '\n';
 
     int ch;
     while((ch = getopt_long(argc, argv,
@@ -264,6 +744,34 @@ int main(int argc, char ** argv)
 	case 'W':
 	    prefer_sweref = false;
 	    break;
+	case 'r':
+	    recursive = true;
+	    break;
+	case 'j':
+	    jobs = std::strtoul(optarg, nullptr, 10);
+	    if (!jobs) {
+		std::cerr << usage << '\n';
+		return 1;
+	    }
+	    break;
+	case 'I':
+	    if (!io_of(optarg, io)) {
+		std::cerr << usage << '\n';
+		return 1;
+	    }
+	    break;
+	case 'S':
+	    stats = true;
+	    break;
+	case 'C':
+	    cache = optarg;
+	    break;
+	case 'F':
+	    files_from = optarg;
+	    break;
+	case '0':
+	    delimiter = '\0';
+	    break;
 	case 'H':
 	    std::cout << usage << '\n';
 	    return 0;
@@ -282,8 +790,23 @@ int main(int argc, char ** argv)
 	}
     }
 
+    Names files {argv+optind, argv+argc};
+    std::ifstream list;
+    if (files_from=="-") {
+	files.list(std::cin, delimiter);
+    }
+    else if (!files_from.empty()) {
+	list.open(files_from);
+	if (!list) {
+	    std::cerr << files_from << ": error: " << std::strerror(errno) << '\n';
+	    return 1;
+	}
+	files.list(list, delimiter);
+    }
+
     Olymp olymp {std::cout, std::cerr,
-		 rename, prefer_sweref, form_clusters};
-    olymp.run({argv+optind, argv+argc});
+		 rename, prefer_sweref, form_clusters, io, jobs, stats,
+		 recursive, cache};
+    olymp.run(files);
     return olymp.status;
 }
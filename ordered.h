@@ -0,0 +1,165 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_ORDERED_H
+#define OLYMP_ORDERED_H
+
+#include <functional>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Applying a function f to a sequence of In, on a number of threads,
+ * and passing the results to a sink function in the same order as
+ * the In were pushed. The sink runs in the pushing thread, so it can
+ * print and so on without locking.
+ *
+ * At most a handful of items per thread are in flight; push() blocks
+ * (and drains finished results into the sink) when that limit is
+ * reached.  Thus memory use doesn't grow with the sequence.
+ *
+ * With one thread, no threads are started; f and the sink simply run
+ * in push().  Out needs to be default-constructible and movable, and
+ * f needs to be safe to run concurrently with itself.
+ */
+template <class In, class Out>
+class Ordered {
+public:
+    using Function = std::function<Out(const In&)>;
+    using Sink = std::function<void(const In&, Out&)>;
+
+    Ordered(unsigned threads, Function f, Sink sink);
+    ~Ordered();
+    Ordered(const Ordered&) = delete;
+    Ordered& operator= (const Ordered&) = delete;
+
+    void push(const In& in);
+    void end();
+
+private:
+    struct Slot {
+	In in;
+	Out out;
+	bool done = false;
+    };
+
+    const Function f;
+    const Sink sink;
+    std::vector<Slot> slots;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable done;
+    bool stopping = false;
+
+    // sequence numbers: next to consume, next to work on, next to push
+    size_t next = 0;
+    size_t head = 0;
+    size_t tail = 0;
+
+    Slot& slot(size_t n) { return slots[n % slots.size()]; }
+    void consume(std::unique_lock<std::mutex>& lock);
+    void worker();
+};
+
+template <class In, class Out>
+Ordered<In, Out>::Ordered(unsigned n, Function f, Sink sink)
+    : f{f},
+      sink{sink}
+{
+    if (n < 2) return;
+    slots.resize(4 * n);
+    for (unsigned i = 0; i < n; i++) {
+	threads.emplace_back(&Ordered::worker, this);
+    }
+}
+
+template <class In, class Out>
+Ordered<In, Out>::~Ordered()
+{
+    {
+	std::lock_guard<std::mutex> lock {mutex};
+	stopping = true;
+    }
+    work.notify_all();
+    for (auto& t : threads) t.join();
+}
+
+/**
+ * Queue 'in' for processing, and pass any results that are ready
+ * (in order) to the sink.
+ */
+template <class In, class Out>
+void Ordered<In, Out>::push(const In& in)
+{
+    if (threads.empty()) {
+	Out out = f(in);
+	sink(in, out);
+	return;
+    }
+
+    std::unique_lock<std::mutex> lock {mutex};
+    while (tail - next == slots.size()) consume(lock);
+
+    Slot& s = slot(tail++);
+    s.in = in;
+    s.done = false;
+    work.notify_one();
+
+    while (next != tail && slot(next).done) consume(lock);
+}
+
+/**
+ * Wait for all queued work, and pass the remaining results
+ * to the sink.
+ */
+template <class In, class Out>
+void Ordered<In, Out>::end()
+{
+    if (threads.empty()) return;
+
+    std::unique_lock<std::mutex> lock {mutex};
+    while (next != tail) consume(lock);
+}
+
+/**
+ * Wait for the oldest result and pass it to the sink, without
+ * holding the lock while doing so.
+ */
+template <class In, class Out>
+void Ordered<In, Out>::consume(std::unique_lock<std::mutex>& lock)
+{
+    Slot& s = slot(next);
+    done.wait(lock, [&s] { return s.done; });
+    lock.unlock();
+    sink(s.in, s.out);
+    s.out = Out {};
+    lock.lock();
+    next++;
+}
+
+template <class In, class Out>
+void Ordered<In, Out>::worker()
+{
+    std::unique_lock<std::mutex> lock {mutex};
+    while (1) {
+	work.wait(lock, [this] { return stopping || head != tail; });
+	if (head == tail) return;
+
+	Slot& s = slot(head++);
+	lock.unlock();
+	Out out = f(s.in);
+	lock.lock();
+	s.out = std::move(out);
+	s.done = true;
+	done.notify_one();
+    }
+}
+
+#endif
@@ -3,13 +3,20 @@
 #include <string>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
 
+#include <getopt.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
 
 #include "jfif.h"
+#include "fileio.h"
+#include "mapping.h"
+#include "uring.h"
+#include "ordered.h"
 
 namespace {
 
@@ -36,7 +43,7 @@ namespace {
     };
 
     std::ostream& describe(std::ostream& os,
-			   const std::vector<jfif::Segment>& v)
+			   const std::vector<jfif::View>& v)
     {
 	for (const auto& seg : v) {
 	    auto it = names.find(seg.marker);
@@ -54,52 +61,336 @@ namespace {
 	return os;
     }
 
-    void seg(std::ostream& os, const std::string& name)
+    /**
+     * What decoding a file results in: its segments, stretches of
+     * entropy-encoded data and scans, or else an error message.
+     */
+    struct Index {
+	std::vector<jfif::View> views;
+	std::vector<jfif::View> entropy;
+	std::vector<jfif::Scan> scans;
+	std::string error;
+    };
+
+    /**
+     * How to read a file with a decoder in 'mode': all of it, in large
+     * chunks, or just the beginning.
+     */
+    Reading reading_of(const jfif::Decoder::Mode mode)
     {
-	jfif::Decoder decoder;
-	const int fd = open(name.c_str(), O_RDONLY);
-	if (fd==-1) {
-	    os << name << ": cannot open: " << std::strerror(errno) << '\n';
-	    return;
+	if (mode==jfif::Decoder::Mode::Full) return {64*1024, 0, nullptr};
+	return {8*1024, 72*1024, nullptr};
+    }
+
+    /**
+     * The error message for a decoder which failed with 'status'.
+     */
+    const char* error_of(jfif::Decoder::Status status)
+    {
+	switch (status) {
+	case jfif::Decoder::Status::IllegalLength:
+	    return "decode error: bad segment length";
+	case jfif::Decoder::Status::Trailer:
+	    return "decode error: trailing data";
+	default:
+	    return "decode error";
 	}
+    }
 
+    /**
+     * The Index for a file, as decoded into 'decoder' by f().  f()
+     * returns the Format of the file, and only for JPEG is the
+     * decoder used; it's then after try_end(), and its status() tells
+     * if decoding failed.  f() throws only on I/O errors.
+     */
+    template <class F>
+    Index attempt(const jfif::Decoder& decoder, F f)
+    {
+	Index index;
 	try {
-	    while (1) {
-		uint8_t buf[64*1024];
-		auto res = read(fd, buf, sizeof buf);
-		if (res==-1) {
-		    os << name << ": error: " << std::strerror(errno) << '\n';
-		}
-		else if (res==0) {
-		    break;
-		}
-		else {
-		    decoder.feed(buf, buf+res);
+	    const Format format = f();
+	    if (format!=Format::Jpeg) {
+		index.error = "not a JPEG file";
+		if (format!=Format::Unknown) {
+		    index.error += std::string(": ") + name_of(format);
 		}
+		return index;
+	    }
+	    if (decoder.status()!=jfif::Decoder::Status::Ok) {
+		index.error = error_of(decoder.status());
+		return index;
 	    }
+	    index.scans = jfif::scans(decoder);
+	    index.views = decoder.views;
+	    index.entropy = decoder.entropy;
+	}
+	catch (const OpenError& e) {
+	    index.error = std::string("cannot open: ") + std::strerror(e.err);
+	}
+	catch (const IOError& e) {
+	    index.error = std::string("error: ") + std::strerror(e.err);
+	}
+	return index;
+    }
+
+    /**
+     * Decode 'name', mapped into memory if possible and 'io' says so,
+     * otherwise by reading it.
+     */
+    Index index(const std::string& name,
+		const jfif::Decoder::Mode mode,
+		const Io io)
+    {
+	// one per thread, reused; 'mode' is the same for every call
+	thread_local jfif::Decoder decoder {mode, {jfif::marker::DRI}};
+	decoder.reset();
+
+	auto f = [&] () {
+		     Cost cost;
+		     const Fd fd {Entry {name}, cost};
+		     const auto map = io==Io::Mmap ? mapping_of(fd) : nullptr;
+		     if (map) {
+			 const Format format = sniff(map->begin(), map->end());
+			 if (format!=Format::Jpeg) return format;
+			 decoder.try_feed(map->begin(), map->end());
+		     }
+		     else {
+			 thread_local std::vector<uint8_t> head;
+			 const Reading reading = reading_of(mode);
+			 const Format format = head_of(fd, reading, head);
+			 if (format!=Format::Jpeg) return format;
+			 feed(decoder, fd, reading, head);
+		     }
+		     decoder.try_end();
+		     return Format::Jpeg;
+		 };
+	return attempt(decoder, f);
+    }
+
+    /**
+     * The segments and entropy-encoded stretches of 'index', in file
+     * order.  The latter have marker 0.
+     */
+    std::vector<jfif::View> merged(const Index& index)
+    {
+	std::vector<jfif::View> v;
+	auto before = [] (const jfif::View& a, const jfif::View& b) {
+			  return a.offset < b.offset;
+		      };
+	std::vector<jfif::View> entropy = index.entropy;
+	for (auto& view : entropy) view.marker = 0;
+	std::merge(begin(index.views), end(index.views),
+		   begin(entropy), end(entropy),
+		   std::back_inserter(v), before);
+	return v;
+    }
 
-	    auto segments = decoder.end();
-	    os << name << ":";
-	    describe(os, segments) << '\n';
+    /**
+     * The marker names, on one line per file.
+     */
+    void names_of(std::ostream& os, const std::string& name,
+		  const Index& index)
+    {
+	if (!index.error.empty()) {
+	    os << name << ": " << index.error << '\n';
+	    return;
 	}
-	catch (jfif::Decoder::IllegalLength&) {
-	    os << name << ": decode error: bad segment length\n";
+	os << name << ":";
+	describe(os, index.views) << '\n';
+    }
+
+    /**
+     * Tab-separated values, one line per segment or stretch of
+     * entropy-encoded data:
+     *
+     *   name  marker  offset  size
+     *
+     * where the marker is e.g. "ffe1", or "data" for entropy-encoded
+     * data, and the offset is that of the data, after the marker and
+     * length field.
+     */
+    void tsv(std::ostream& os, const std::string& name,
+	     const Index& index)
+    {
+	for (const auto& view : merged(index)) {
+	    char buf[5] = "data";
+	    if (view.marker) std::snprintf(buf, sizeof buf, "ff%02x", view.marker);
+	    os << name << '\t' << buf
+	       << '\t' << view.offset
+	       << '\t' << view.size << '\n';
 	}
-	catch (jfif::Decoder::Trailer&) {
-	    os << name << ": decode error: trailing data\n";
+    }
+
+    /**
+     * The scans, for decoding them in parallel, as tab-separated
+     * values; one line per chunk of entropy-encoded data:
+     *
+     *   name  scan  interval  marker  offset  size
+     *
+     * where 'scan' counts from 0, 'interval' is the restart interval
+     * in MCUs (0 if there are no restarts), and the marker is the one
+     * the chunk follows; ffda or ffd0--ffd7.
+     */
+    void scans(std::ostream& os, const std::string& name,
+	       const Index& index)
+    {
+	unsigned n = 0;
+	for (const auto& scan : index.scans) {
+	    for (const auto& chunk : scan.chunks) {
+		char buf[5];
+		std::snprintf(buf, sizeof buf, "ff%02x", chunk.marker);
+		os << name << '\t' << n
+		   << '\t' << scan.interval
+		   << '\t' << buf
+		   << '\t' << chunk.offset
+		   << '\t' << chunk.size << '\n';
+	    }
+	    n++;
+	}
+    }
+
+    template <class T>
+    void put_le(std::string& s, T val, unsigned n)
+    {
+	while (n--) {
+	    s.push_back(val & 0xff);
+	    val >>= 8;
 	}
-	catch (jfif::Decoder::Error&) {
-	    os << name << ": decode error\n";
+    }
+
+    /**
+     * A compact binary index, with all integers little-endian:
+     *
+     *   u32  name size
+     *   ...  name
+     *   u32  number of entries, each 16 octets:
+     *        u8   marker, or 0 for entropy-encoded data
+     *        u8   0, 0, 0
+     *        u32  size
+     *        u64  offset
+     */
+    void binary(std::ostream& os, const std::string& name,
+		const Index& index)
+    {
+	const auto v = merged(index);
+	std::string s;
+	put_le(s, name.size(), 4);
+	s += name;
+	put_le(s, v.size(), 4);
+	for (const auto& view : v) {
+	    put_le(s, view.marker, 4);
+	    put_le(s, view.size, 4);
+	    put_le(s, view.offset, 8);
 	}
-	close(fd);
+	os.write(s.data(), s.size());
     }
 }
 
 int main(int argc, char** argv)
 {
-    const std::vector<std::string> args {&argv[1], &argv[argc]};
-    for (auto name: args) {
-	seg(std::cout, name);
+    const std::string prog = argv[0] ? argv[0] : "seg";
+    const std::string usage = "usage: " + prog
+	+ " [-H] [-t | -b | -s] [-j jobs] [--io=read|mmap|uring] file ...";
+    const struct option long_options[] = {
+	{"io", 1, 0, 'I'},
+	{0, 0, 0, 0}
+    };
+
+    auto mode = jfif::Decoder::Mode::Full;
+    auto format = names_of;
+    unsigned jobs = 1;
+    Io io = Io::Mmap;
+
+    int ch;
+    while ((ch = getopt_long(argc, argv, "Htbsj:",
+			     &long_options[0], 0)) != -1) {
+	switch (ch) {
+	case 'H':
+	    mode = jfif::Decoder::Mode::Headers;
+	    break;
+	case 't':
+	    format = tsv;
+	    break;
+	case 'b':
+	    format = binary;
+	    break;
+	case 's':
+	    format = scans;
+	    break;
+	case 'I':
+	    if (!io_of(optarg, io)) {
+		std::cerr << usage << '\n';
+		return 1;
+	    }
+	    break;
+	case 'j':
+	    jobs = std::strtoul(optarg, nullptr, 10);
+	    if (jobs) break;
+	    // fall through
+	default:
+	    std::cerr << usage << '\n';
+	    return 1;
+	}
+    }
+
+    std::cout.sync_with_stdio(false);
+    int status = 0;
+
+    auto sink = [&] (const std::string& name, const Index& index) {
+		    if (index.error.empty()) {
+			format(std::cout, name, index);
+		    }
+		    else {
+			status = 1;
+			if (format==names_of) {
+			    names_of(std::cout, name, index);
+			}
+			else {
+			    std::cerr << name << ": " << index.error << '\n';
+			}
+		    }
+		};
+    const std::vector<std::string> args {&argv[optind], &argv[argc]};
+
+    std::unique_ptr<Uring> ring;
+    if (io==Io::Uring) {
+	ring.reset(new Uring {64});
+	if (!ring->valid()) ring.reset();
+    }
+
+    if (ring) {
+	auto done = [&sink] (const Entry& file,
+			     Format format,
+			     const jfif::Decoder& decoder,
+			     std::exception_ptr error,
+			     const Cost&) {
+			auto f = [&] () {
+				     if (error) std::rethrow_exception(error);
+				     return format;
+				 };
+			sink(file.name, attempt(decoder, f));
+		    };
+	Batch batch {*ring, mode, {jfif::marker::DRI}, reading_of(mode), done};
+	try {
+	    for (auto name: args) {
+		batch.push(Entry {name}, true);
+	    }
+	    batch.end();
+	}
+	catch (const IOError& e) {
+	    std::cerr << "error: io_uring: " << std::strerror(e.err) << '\n';
+	    status = 1;
+	}
+    }
+    else {
+	auto f = [mode, io] (const std::string& name) {
+		     return index(name, mode, io);
+		 };
+	Ordered<std::string, Index> pool {jobs, f, sink};
+	for (auto name: args) {
+	    pool.push(name);
+	}
+	pool.end();
     }
-    return 0;
+    return status;
 }
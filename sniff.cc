@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#include "sniff.h"
+
+#include <cstring>
+
+namespace {
+
+    /**
+     * True if [a, b) starts with the 4-octet 'magic'.
+     */
+    bool starts(const uint8_t* a, const uint8_t* b, const char* magic)
+    {
+	return b - a >= 4 && std::memcmp(a, magic, 4)==0;
+    }
+
+    bool tiff(const uint8_t* a, const uint8_t* b)
+    {
+	static const char magics[][5] = {
+	    "II*\0", "MM\0*",
+	    "IIRO", "IIRS", "MMOR", // Olympus
+	    "IIU\0",                // Panasonic
+	};
+	for (const char* magic : magics) {
+	    if (starts(a, b, magic)) return true;
+	}
+	return false;
+    }
+}
+
+/**
+ * The Format of a file starting with [a, b).  Looks at no more than
+ * sniff_size octets.
+ */
+Format sniff(const uint8_t* a, const uint8_t* b)
+{
+    if (a==b) return Format::Unknown;
+    if (*a==0xff) return Format::Jpeg;
+    if (tiff(a, b)) return Format::Tiff;
+    if (b - a >= 8 && starts(a+4, b, "ftyp")) return Format::Bmff;
+    return Format::Unknown;
+}
+
+const char* name_of(Format format)
+{
+    switch (format) {
+    case Format::Jpeg: return "JPEG";
+    case Format::Tiff: return "TIFF";
+    case Format::Bmff: return "ISO BMFF";
+    case Format::Unknown: break;
+    }
+    return "unknown";
+}
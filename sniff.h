@@ -0,0 +1,40 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_SNIFF_H
+#define OLYMP_SNIFF_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * What a file is, as far as its first few octets tell:
+ *
+ * - JPEG (JFIF or Exif); starts with FF.  The Decoder has the final
+ *   word.
+ * - TIFF, including raw formats built on it, like Olympus ORF and
+ *   Panasonic RW2.
+ * - ISO base media files: HEIF/HEIC, AVIF, MP4, QuickTime and so
+ *   on; they start with an 'ftyp' box.
+ * - Anything else, including files too short to tell.
+ */
+enum class Format {
+    Unknown,
+    Jpeg,
+    Tiff,
+    Bmff
+};
+
+/**
+ * How many octets sniff() may need to look at.
+ */
+constexpr size_t sniff_size = 8;
+
+Format sniff(const uint8_t* a, const uint8_t* b);
+
+const char* name_of(Format format);
+
+#endif
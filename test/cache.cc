@@ -0,0 +1,119 @@
+#include <orchis.h>
+
+#include <cache.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <unistd.h>
+
+namespace cache {
+
+    using orchis::TC;
+    using orchis::assert_eq;
+    using orchis::assert_true;
+    using orchis::assert_false;
+
+    /**
+     * A temporary file name, removed afterwards.
+     */
+    struct Tmp {
+	Tmp()
+	{
+	    char s[] = "/tmp/olymp-cacheXXXXXX";
+	    close(mkstemp(s));
+	    std::remove(s);
+	    path = s;
+	}
+	~Tmp() { std::remove(path.c_str()); }
+	std::string path;
+    };
+
+    Cache::Key key(unsigned ino, unsigned mtime)
+    {
+	Cache::Key key;
+	key.dev = 42;
+	key.ino = ino;
+	key.size = 4711;
+	key.mtime = mtime;
+	return key;
+    }
+
+    Metadata meta(const char* ts, double lat = 0, double lon = 0)
+    {
+	return {Serial {1234},
+		exif::DateTimeOriginal {std::string {ts}},
+		wgs84::Coordinate {lat, lon}};
+    }
+
+    void empty(TC)
+    {
+	Tmp tmp;
+	Cache cache {tmp.path};
+	assert_false(cache.find(key(1, 1), Serial {1}).get());
+	assert_true(cache.save());
+    }
+
+    void roundtrip(TC)
+    {
+	Tmp tmp;
+	{
+	    Cache cache {tmp.path};
+	    cache.insert(key(2, 100), meta("2019:09:12 22:30:59", 59.5, 18.25));
+	    cache.insert(key(1, 100), meta("2019:09:13 10:00:00"));
+	    assert_false(cache.find(key(1, 100), Serial {1}).get());
+	    assert_true(cache.save());
+	}
+
+	Cache cache {tmp.path};
+	auto m = cache.find(key(2, 100), Serial {17});
+	assert_true(m.get());
+	assert_eq(m->filename(), "2019-09-12_0017.jpg");
+	assert_eq(m->timestamp().str(), "2019:09:12 22:30:59");
+	assert_eq(m->coordinate().lat(), 59.5);
+	assert_eq(m->coordinate().lon(), 18.25);
+
+	m = cache.find(key(1, 100), Serial {1});
+	assert_true(m.get());
+	assert_false(m->coordinate().valid());
+
+	assert_false(cache.find(key(3, 100), Serial {1}).get());
+    }
+
+    void changed(TC)
+    {
+	Tmp tmp;
+	{
+	    Cache cache {tmp.path};
+	    cache.insert(key(1, 100), meta("2019:09:12 22:30:59"));
+	    cache.insert(key(2, 100), meta("2019:09:12 22:31:00"));
+	    assert_true(cache.save());
+	}
+	{
+	    Cache cache {tmp.path};
+	    assert_false(cache.find(key(1, 101), Serial {1}).get());
+	    cache.insert(key(1, 101), meta("2020:01:01 00:00:00"));
+	    assert_true(cache.save());
+	}
+
+	Cache cache {tmp.path};
+	assert_false(cache.find(key(1, 100), Serial {1}).get());
+	auto m = cache.find(key(1, 101), Serial {1});
+	assert_true(m.get());
+	assert_eq(m->timestamp().str(), "2020:01:01 00:00:00");
+	assert_true(cache.find(key(2, 100), Serial {1}).get());
+    }
+
+    void garbage(TC)
+    {
+	Tmp tmp;
+	std::FILE* f = std::fopen(tmp.path.c_str(), "w");
+	std::fputs("not a cache\n", f);
+	std::fclose(f);
+
+	Cache cache {tmp.path};
+	assert_false(cache.find(key(1, 1), Serial {1}).get());
+	cache.insert(key(1, 1), meta("2019:09:12 22:30:59"));
+	assert_true(cache.save());
+	assert_true(Cache {tmp.path}.find(key(1, 1), Serial {1}).get());
+    }
+}
@@ -37,4 +37,15 @@ namespace endianness {
 	orchis::assert_eq(le.eat16(b), 0x4433);
 	orchis::assert_eq(b, e);
     }
+
+    void dispatch(orchis::TC)
+    {
+	std::array<uint8_t, 2> v { 0x11, 0x22 };
+	auto eat16 = [&v] (const auto& en) {
+			 const uint8_t* a = v.data();
+			 return en.eat16(a);
+		     };
+	orchis::assert_eq(tiff::dispatch(tiff::ByteOrder::Motorola, eat16), 0x1122);
+	orchis::assert_eq(tiff::dispatch(tiff::ByteOrder::Intel, eat16), 0x2211);
+    }
 }
@@ -0,0 +1,102 @@
+#include <orchis.h>
+#include "hexread.h"
+
+#include <entropy.h>
+
+#include <vector>
+#include <random>
+
+namespace entropy {
+
+    using orchis::TC;
+    using orchis::assert_eq;
+
+    using Scan = const uint8_t* (*)(const uint8_t*, const uint8_t*);
+
+    /**
+     * Offset of the first FF not followed by 00 in 'v', or v.size(),
+     * the slow way.
+     */
+    size_t ref(const std::vector<uint8_t>& v)
+    {
+	for (size_t i = 0; i < v.size(); i++) {
+	    if (v[i]!=0xff) continue;
+	    if (i+1==v.size() || v[i+1]) return i;
+	}
+	return v.size();
+    }
+
+    void assert_scans(Scan f, const std::vector<uint8_t>& v)
+    {
+	const uint8_t* a = v.data();
+	assert_eq(f(a, a + v.size()) - a, ref(v));
+    }
+
+    void assert_scans(const std::vector<uint8_t>& v)
+    {
+	assert_scans(jfif::scan, v);
+	assert_scans(jfif::entropy::scalar, v);
+	if (jfif::entropy::have_sse2()) assert_scans(jfif::entropy::sse2, v);
+	if (jfif::entropy::have_avx2()) assert_scans(jfif::entropy::avx2, v);
+    }
+
+    void simple(TC)
+    {
+	assert_scans(hexread(""));
+	assert_scans(hexread("00"));
+	assert_scans(hexread("ff"));
+	assert_scans(hexread("ff00"));
+	assert_scans(hexread("ff00 ff"));
+	assert_scans(hexread("ff00 ffd9"));
+	assert_scans(hexread("ff00 ffff 00"));
+	assert_scans(hexread("0102 0304 ffd0 0506"));
+    }
+
+    /**
+     * A marker at each position of a 100-octet stretch of stuffed
+     * data, so every lane of every block gets its turn, and so does
+     * the scalar tail.
+     */
+    void positions(TC)
+    {
+	for (unsigned n = 0; n < 100; n++) {
+	    std::vector<uint8_t> v(100, 0x11);
+	    for (unsigned i = 0; i+1 < n; i += 5) {
+		v[i] = 0xff;
+		v[i+1] = 0x00;
+	    }
+	    assert_scans(v);
+	    v[n] = 0xff;
+	    if (n+1 < 100) v[n+1] = 0xd9;
+	    assert_scans(v);
+	}
+    }
+
+    void stuffed_across_blocks(TC)
+    {
+	for (unsigned n = 1; n < 70; n++) {
+	    std::vector<uint8_t> v(70, 0x11);
+	    v[n-1] = 0xff;
+	    v[n] = 0x00;
+	    assert_scans(v);
+	    v.resize(n);
+	    assert_scans(v);
+	}
+    }
+
+    void random(TC)
+    {
+	std::minstd_rand rng;
+	for (unsigned n = 0; n < 1000; n++) {
+	    std::vector<uint8_t> v(n % 200);
+	    for (auto& ch : v) {
+		switch (rng() % 4) {
+		case 0: ch = 0xff; break;
+		case 1: ch = 0x00; break;
+		default: ch = rng();
+		}
+	    }
+	    assert_scans(v);
+	}
+    }
+}
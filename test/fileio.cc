@@ -0,0 +1,128 @@
+#include <orchis.h>
+#include "hexread.h"
+
+#include <fileio.h>
+
+#include <string>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+namespace fileio {
+
+    using orchis::TC;
+    using orchis::assert_eq;
+    using orchis::assert_true;
+
+    /**
+     * A JPEG file with a large APP1, so that there's something to
+     * skip.
+     */
+    std::vector<uint8_t> jpeg()
+    {
+	std::vector<uint8_t> v = hexread("ffd8 ffe1 4e22");
+	v.resize(v.size() + 20000, 0x47);
+	const auto tail = hexread("ffdb 0005 010203"
+				  "ffda 0002 0123 ff00 ffd9");
+	v.insert(v.end(), tail.begin(), tail.end());
+	return v;
+    }
+
+    /**
+     * A pipe holding 'data', as a file name to open.  The data has to
+     * fit in the pipe's buffer.
+     */
+    struct Pipe {
+	explicit Pipe(const std::vector<uint8_t>& data)
+	{
+	    int fd[2];
+	    if (pipe(fd)) throw orchis::Failure {"pipe(2) failed"};
+	    r = fd[0];
+	    if (write(fd[1], data.data(), data.size())!=ssize_t(data.size())) {
+		throw orchis::Failure {"write(2) failed"};
+	    }
+	    close(fd[1]);
+	}
+	~Pipe() { close(r); }
+	std::string name() const { return "/dev/fd/" + std::to_string(r); }
+	int r;
+    };
+
+    void decode(jfif::Decoder& decoder, const Entry& file,
+		const Reading& reading)
+    {
+	Cost cost;
+	const Fd fd {file, cost};
+	std::vector<uint8_t> head;
+	assert_true(head_of(fd, reading, head)==Format::Jpeg);
+	feed(decoder, fd, reading, head);
+	decoder.try_end();
+    }
+
+    void assert_decodes(const Reading& reading,
+			jfif::Decoder::Mode mode, const jfif::Markers& keep)
+    {
+	const auto v = jpeg();
+	jfif::Decoder ref {mode, keep};
+	ref.try_feed(v.data(), v.data() + v.size());
+	ref.try_end();
+
+	const Pipe pipe {v};
+	jfif::Decoder decoder {mode, keep};
+	decode(decoder, Entry {pipe.name()}, reading);
+	assert_true(decoder.status()==jfif::Decoder::Status::Ok);
+	assert_true(decoder.views==ref.views);
+	assert_true(decoder.v==ref.v);
+    }
+
+    namespace piped {
+
+	using jfif::Decoder;
+	using jfif::Markers;
+
+	void full(TC)
+	{
+	    assert_decodes({64*1024, 0, nullptr},
+			   Decoder::Mode::Full, Markers::all());
+	}
+
+	void skipped(TC)
+	{
+	    assert_decodes({64*1024, 0, nullptr},
+			   Decoder::Mode::Full, Markers {});
+	    assert_decodes({1024, 0, nullptr},
+			   Decoder::Mode::Full, Markers {});
+	}
+
+	void headers(TC)
+	{
+	    assert_decodes({8*1024, 72*1024, nullptr},
+			   Decoder::Mode::Headers, Markers {});
+	}
+
+	/* A slow writer: the first read of the head only gets one
+	 * octet, which isn't enough to tell it's a JPEG file.
+	 */
+	void trickle(TC)
+	{
+	    const auto v = jpeg();
+	    int fd[2];
+	    assert_true(pipe(fd)==0);
+	    std::thread writer {[&v, &fd] {
+		    ssize_t n = write(fd[1], v.data(), 1);
+		    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		    n += write(fd[1], v.data() + 1, v.size() - 1);
+		    close(fd[1]);
+		}};
+
+	    Cost cost;
+	    const Fd file {Entry {"/dev/fd/" + std::to_string(fd[0])}, cost};
+	    std::vector<uint8_t> head;
+	    const Format format = head_of(file, {8*1024, 0, nullptr}, head);
+	    writer.join();
+	    close(fd[0]);
+	    assert_true(format==Format::Jpeg);
+	    assert_eq(head.size(), 8*1024);
+	}
+    }
+}
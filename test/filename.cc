@@ -65,4 +65,15 @@ namespace filename {
 	assert_eq(s1234, serial(".//pa051234.jpg"));
 	assert_eq(s1234, serial("/pa051234.jpg"));
     }
+
+    void ext(TC)
+    {
+	assert_eq(extension("pa051234.jpg"), ".jpg");
+	assert_eq(extension("foo/P1010001.ORF"), ".ORF");
+	assert_eq(extension("foo.tar.gz"), ".gz");
+	assert_eq(extension("foo.d/bar"), "");
+	assert_eq(extension("foo/.bar"), "");
+	assert_eq(extension("foo/"), "");
+	assert_eq(extension(""), "");
+    }
 }
@@ -1,4 +1,5 @@
 #include <vector>
+#include <string>
 #include <orchis.h>
 #include "hexread.h"
 
@@ -13,9 +14,10 @@ namespace {
 namespace jfif {
 
     std::vector<Segment> parse(const uint8_t *a, const uint8_t *b,
-			       const size_t stepping)
+			       const size_t stepping,
+			       const Decoder::Mode mode = Decoder::Mode::Full)
     {
-	Decoder decoder;
+	Decoder decoder {mode};
 	while(a!=b) {
 	    auto c = std::min(a+stepping, b);
 	    decoder.feed(a, c);
@@ -117,6 +119,512 @@ namespace jfif {
 	}
     }
 
+    namespace headers {
+
+	using Mode = Decoder::Mode;
+
+	void assert_parses(const std::vector<uint8_t>& v,
+			   const std::vector<Segment>& ref)
+	{
+	    const auto a = v.data();
+	    const auto b = a + v.size();
+
+	    try {
+		for(size_t n = v.size(); n; n--) {
+		    const auto v = parse(a, b, n, Mode::Headers);
+		    orchis::assert_(v == ref);
+		}
+	    }
+	    catch (const Decoder::Error&) {
+		throw orchis::Failure("Decoder::Error");
+	    }
+	}
+
+	void simple(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe1 0004 4711"
+			     "ffda 0003 69"
+			     "0123456789abcdef"
+			     "ffd9");
+
+	    assert_parses(v,
+			  {{0xd8, h("")},
+			   {0xe1, h("4711")},
+			   {0xda, h("69")}});
+	}
+
+	void garbage(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffda 0002"
+			     "ffe0 0001"
+			     "ffe0 0042 69");
+
+	    assert_parses(v,
+			  {{0xd8, h("")},
+			   {0xda, h("")}});
+	}
+
+	void done(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe1 0004 4711"
+			     "ffda 0003 69");
+	    Decoder decoder {Mode::Headers};
+	    for (auto it = v.begin(); it != v.end(); it++) {
+		orchis::assert_false(decoder.done());
+		decoder.feed(&*it, &*it + 1);
+	    }
+	    orchis::assert_true(decoder.done());
+	}
+
+	void no_sos(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe1 0004 4711"
+			     "0123456789abcdef"
+			     "ffd9");
+
+	    assert_parses(v,
+			  {{0xd8, h("")},
+			   {0xe1, h("4711")},
+			   {0xd9, h("")}});
+	}
+
+	void wanted(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe1 0006 4711 4712"
+			     "ffda 0003 69");
+	    const std::vector<size_t> ref {0, 0, 0, 0, 0, 0,
+					   4, 3, 2, 1,
+					   0, 0, 0, 0,
+					   1, 0};
+	    Decoder decoder {Mode::Headers};
+	    std::vector<size_t> w {decoder.wanted()};
+	    for (auto it = v.begin(); it != v.end(); it++) {
+		decoder.feed(&*it, &*it + 1);
+		w.push_back(decoder.wanted());
+	    }
+	    orchis::assert_true(w == ref);
+	}
+    }
+
+    namespace views {
+
+	void assert_views(const std::vector<uint8_t>& v,
+			  const std::vector<View>& ref)
+	{
+	    const auto a = v.data();
+	    const auto b = a + v.size();
+
+	    for(size_t n = v.size(); n; n--) {
+		Decoder decoder {Decoder::Mode::Full, {}};
+		for (auto p = a; p!=b; ) {
+		    auto c = std::min(p+n, b);
+		    decoder.feed(p, c);
+		    p = c;
+		}
+		orchis::assert_true(decoder.end().empty());
+		orchis::assert_true(decoder.views == ref);
+	    }
+	}
+
+	void simple(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe0 0003 69"
+			     "0123456789abcdef"
+			     "ffe1 0006 00112233"
+			     "ffd9");
+
+	    assert_views(v,
+			 {{0xd8,  2, 0},
+			  {0xe0,  6, 1},
+			  {0xe1, 19, 4},
+			  {0xd9, 25, 0}});
+	}
+
+	void padding(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffffff"
+			     "ffe0 0002"
+			     "ffe0 0003 69");
+
+	    assert_views(v,
+			 {{0xd8,  2, 0},
+			  {0xe0,  9, 0},
+			  {0xe0, 13, 1}});
+	}
+
+	void data(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe1 0006 00112233"
+			     "ffd9");
+	    Decoder decoder {Decoder::Mode::Full, {}};
+	    decoder.feed(v.data(), v.data() + v.size());
+	    const View& app1 = decoder.views.at(1);
+	    const std::vector<uint8_t> ref {app1.begin(v.data()),
+					    app1.end(v.data())};
+	    orchis::assert_true(ref == h("00112233"));
+	}
+    }
+
+    namespace entropy {
+
+	void assert_entropy(const std::vector<uint8_t>& v,
+			    const std::vector<View>& ref)
+	{
+	    const auto a = v.data();
+	    const auto b = a + v.size();
+
+	    for(size_t n = v.size(); n; n--) {
+		Decoder decoder {Decoder::Mode::Full, {}};
+		for (auto p = a; p!=b; ) {
+		    auto c = std::min(p+n, b);
+		    decoder.feed(p, c);
+		    p = c;
+		}
+		decoder.end();
+		orchis::assert_true(decoder.entropy == ref);
+	    }
+	}
+
+	void simple(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffda 0003 69"
+			     "0123 ff00 4567"
+			     "ffd0"
+			     "89ab ff00"
+			     "ffd9");
+
+	    assert_entropy(v,
+			   {{0xda,  7, 6},
+			    {0xd0, 15, 4}});
+	}
+
+	void padding(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffda 0002"
+			     "0123 ff00"
+			     "ffff ffd9");
+
+	    assert_entropy(v, {{0xda,  6, 4}});
+	}
+
+	void unterminated(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffda 0002"
+			     "0123 ff00 45");
+
+	    assert_entropy(v, {{0xda,  6, 5}});
+	}
+
+	void none(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe0 0003 69"
+			     "ffda 0002"
+			     "ffd9");
+
+	    assert_entropy(v, {});
+	}
+    }
+
+    namespace reset {
+
+	const auto a = h("ffd8"
+			 "ffe0 0003 69"
+			 "ffe1 0006 00112233"
+			 "ffda 0002"
+			 "0123 ff00"
+			 "ffd9");
+	const auto b = h("ffd8"
+			 "ffe1 0004 4711"
+			 "ffdb 0005 010203"
+			 "ffd9");
+
+	void decode(Decoder& decoder, const std::vector<uint8_t>& v)
+	{
+	    decoder.feed(v.data(), v.data() + v.size());
+	    decoder.end();
+	}
+
+	void assert_same(const Decoder& a, const Decoder& b)
+	{
+	    orchis::assert_true(a.v == b.v);
+	    orchis::assert_true(a.views == b.views);
+	    orchis::assert_true(a.entropy == b.entropy);
+	}
+
+	void simple(orchis::TC)
+	{
+	    Decoder decoder;
+	    for (const auto& v : {a, b, a, a, b}) {
+		decoder.reset();
+		decode(decoder, v);
+		Decoder ref;
+		decode(ref, v);
+		assert_same(decoder, ref);
+	    }
+	}
+
+	void midway(orchis::TC)
+	{
+	    for (size_t n = 0; n < a.size(); n++) {
+		Decoder decoder {Decoder::Mode::Full, {marker::APP1}};
+		decoder.feed(a.data(), a.data() + n);
+		decoder.reset();
+		decode(decoder, b);
+		Decoder ref {Decoder::Mode::Full, {marker::APP1}};
+		decode(ref, b);
+		assert_same(decoder, ref);
+	    }
+	}
+
+	void identified(orchis::TC)
+	{
+	    const auto keep = Markers {}.add(marker::APP1, std::string {"\x00\x11", 2});
+	    Decoder decoder {Decoder::Mode::Headers, keep};
+	    for (const auto& v : {a, b, a}) {
+		decoder.reset();
+		decode(decoder, v);
+		Decoder ref {Decoder::Mode::Headers, keep};
+		decode(ref, v);
+		assert_same(decoder, ref);
+	    }
+	}
+
+	void restarts(orchis::TC)
+	{
+	    std::string s = "ffd8 ffe1 0004 4711 ffda 0002";
+	    for (unsigned n = 0; n < 100; n++) {
+		s += "00 ffd" + std::to_string(n % 8);
+	    }
+	    s += "ffd9";
+	    const auto c = h(s);
+
+	    Decoder decoder;
+	    Decoder ref;
+	    decode(ref, c);
+	    for (unsigned n = 0; n < 100; n++) {
+		decoder.reset();
+		decode(decoder, c);
+	    }
+	    assert_same(decoder, ref);
+	}
+
+	void capacity(orchis::TC)
+	{
+	    Decoder decoder;
+	    decode(decoder, a);
+	    const auto n = decoder.views.capacity();
+	    decoder.reset();
+	    orchis::assert_true(decoder.views.empty());
+	    orchis::assert_eq(decoder.views.capacity(), n);
+	}
+    }
+
+    namespace skip {
+
+	const auto v = h("ffd8"
+			 "ffe1 0008 457869660000"
+			 "ffe1 000a 0011 0123456789ab"
+			 "ffe2 0004 4711"
+			 "ffda 0003 69"
+			 "0123 ff00"
+			 "ffd9");
+
+	/**
+	 * Decode 'v' in chunks of 'n' octets, skipping what can be
+	 * skipped, and return the number of octets actually fed.
+	 */
+	size_t decode(Decoder& decoder, const std::vector<uint8_t>& v, size_t n)
+	{
+	    size_t fed = 0;
+	    auto a = v.data();
+	    const auto b = a + v.size();
+	    while (a!=b) {
+		auto c = std::min(a+n, b);
+		decoder.feed(a, c);
+		fed += c - a;
+		a = c;
+		const size_t m = decoder.skippable();
+		orchis::assert_true(m <= size_t(b - a));
+		decoder.skip(m);
+		a += m;
+	    }
+	    decoder.end();
+	    return fed;
+	}
+
+	void assert_skips(const Markers& keep)
+	{
+	    Decoder ref {Decoder::Mode::Full, keep};
+	    decode(ref, v, v.size());
+
+	    for(size_t n = v.size(); n; n--) {
+		Decoder decoder {Decoder::Mode::Full, keep};
+		decode(decoder, v, n);
+		orchis::assert_true(decoder.v == ref.v);
+		orchis::assert_true(decoder.views == ref.views);
+		orchis::assert_true(decoder.entropy == ref.entropy);
+	    }
+	}
+
+	void none(orchis::TC)
+	{
+	    assert_skips({});
+	}
+
+	void some(orchis::TC)
+	{
+	    assert_skips({marker::APP2});
+	}
+
+	void identified(orchis::TC)
+	{
+	    assert_skips(Markers {}.add(marker::APP1, identifier::Exif));
+	}
+
+	void fed(orchis::TC)
+	{
+	    Decoder decoder {Decoder::Mode::Full, {}};
+	    // all but what's in the first chunk of each APPn
+	    orchis::assert_eq(decode(decoder, v, 5), v.size() - 2 - 7 - 1);
+	}
+
+	void kept(orchis::TC)
+	{
+	    Decoder decoder {Decoder::Mode::Full, {marker::APP1}};
+	    const auto n = v.size();
+	    decoder.feed(v.data(), v.data() + 8);
+	    orchis::assert_eq(decoder.skippable(), 0);
+	    decoder.skip(2);
+	    decoder.feed(v.data() + 8, v.data() + n);
+	    orchis::assert_eq(decoder.end().size(), 2);
+	}
+    }
+
+    namespace scan {
+
+	std::vector<Scan> scans(const std::vector<uint8_t>& v,
+				const Markers& keep)
+	{
+	    Decoder decoder {Decoder::Mode::Full, keep};
+	    decoder.feed(v.data(), v.data() + v.size());
+	    decoder.end();
+	    return jfif::scans(decoder);
+	}
+
+	const auto v = h("ffd8"
+			 "ffdd 0004 0010"
+			 "ffda 0003 69"
+			 "0123"
+			 "ffd0"
+			 "ffd1"
+			 "45 ff00"
+			 "ffda 0002"
+			 "89"
+			 "ffd9");
+
+	void simple(orchis::TC)
+	{
+	    const auto s = scans(v, {marker::DRI});
+	    orchis::assert_eq(s.size(), 2);
+
+	    orchis::assert_true(s[0].sos == View(0xda, 12, 1));
+	    orchis::assert_eq(s[0].interval, 16);
+	    orchis::assert_true(s[0].chunks == std::vector<View>({{0xda, 13, 2},
+								  {0xd0, 17, 0},
+								  {0xd1, 19, 3}}));
+
+	    orchis::assert_true(s[1].sos == View(0xda, 26, 0));
+	    orchis::assert_eq(s[1].interval, 16);
+	    orchis::assert_true(s[1].chunks == std::vector<View>({{0xda, 26, 1}}));
+	}
+
+	void no_dri(orchis::TC)
+	{
+	    const auto s = scans(v, {});
+	    orchis::assert_eq(s.size(), 2);
+	    orchis::assert_eq(s[0].interval, 0);
+	    orchis::assert_eq(s[0].chunks.size(), 3);
+	}
+    }
+
+    namespace keep {
+
+	std::vector<Segment> parse(const std::vector<uint8_t>& v,
+				   const size_t stepping,
+				   const Markers& keep)
+	{
+	    Decoder decoder {Decoder::Mode::Full, keep};
+	    auto a = v.data();
+	    const auto b = a + v.size();
+	    while(a!=b) {
+		auto c = std::min(a+stepping, b);
+		decoder.feed(a, c);
+		a = c;
+	    }
+	    return decoder.end();
+	}
+
+	const auto v = h("ffd8"
+			 "ffe0 0003 69"
+			 "ffe1 0006 00112233"
+			 "ffe2 0004 4711"
+			 "ffd9");
+
+	void some(orchis::TC)
+	{
+	    for(size_t n = v.size(); n; n--) {
+		orchis::assert_(parse(v, n, {0xe1}) ==
+				std::vector<Segment> {{0xe1, h("00112233")}});
+		orchis::assert_(parse(v, n, {0xd8, 0xe2}) ==
+				std::vector<Segment> {{0xd8, {}},
+						      {0xe2, h("4711")}});
+	    }
+	}
+
+	void none(orchis::TC)
+	{
+	    for(size_t n = v.size(); n; n--) {
+		orchis::assert_(parse(v, n, {}).empty());
+	    }
+	}
+
+	void all(orchis::TC)
+	{
+	    for(size_t n = v.size(); n; n--) {
+		orchis::assert_eq(parse(v, n, Markers::all()).size(), 5);
+	    }
+	}
+
+	void identified(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe1 0008 457869660000"
+			     "ffe1 0007 4578696600"
+			     "ffe1 0002"
+			     "ffe1 000a 457869660001 4711"
+			     "ffe1 000a 457869660000 4711");
+	    const auto exif = Markers {}.add(0xe1, identifier::Exif);
+
+	    for(size_t n = v.size(); n; n--) {
+		orchis::assert_(parse(v, n, exif) ==
+				std::vector<Segment> {{0xe1, h("457869660000")},
+						      {0xe1, h("457869660000 4711")}});
+	    }
+	}
+    }
+
     namespace bad {
 
 	void empty(orchis::TC)
@@ -209,4 +717,85 @@ namespace jfif {
 	    }
 	}
     }
+
+    namespace status {
+
+	using S = Decoder::Status;
+
+	/**
+	 * Decode 'v' without exceptions, 'stepping' octets at a time,
+	 * the way a caller would: stopping at the first failure.
+	 */
+	S decode(Decoder& decoder, const std::vector<uint8_t>& v,
+		 const size_t stepping)
+	{
+	    auto a = v.data();
+	    const auto b = a + v.size();
+	    while(a!=b) {
+		auto c = std::min(a+stepping, b);
+		const S s = decoder.try_feed(a, c);
+		if (s!=S::Ok) return s;
+		a = c;
+	    }
+	    return decoder.try_end();
+	}
+
+	void assert_status(const std::vector<uint8_t>& v, S ref)
+	{
+	    for(size_t n = v.size(); n; n--) {
+		Decoder decoder;
+		orchis::assert_true(decode(decoder, v, n) == ref);
+		orchis::assert_true(decoder.status() == ref);
+		orchis::assert_true(decoder.done());
+	    }
+	}
+
+	void good(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe0 0004 4711"
+			     "ffd9");
+	    assert_status(v, S::Ok);
+
+	    Decoder decoder;
+	    decode(decoder, v, 3);
+	    orchis::assert_true(decoder.v == parse(v.data(), v.data() + v.size(), 3));
+	}
+
+	void bad(orchis::TC)
+	{
+	    assert_status(h("ffd8"
+			    "ffe0 0001"), S::IllegalLength);
+	    assert_status(h("ff00 1234"
+			    "ffd8"), S::FalseStart);
+	    assert_status(h("ffd8"
+			    "ffe0 0004 4711"
+			    "ffe0 0005 6970"), S::Trailer);
+	}
+
+	void sticky(orchis::TC)
+	{
+	    const auto v = h("ffd8"
+			     "ffe0 0004 4711"
+			     "ffe0 0001"
+			     "ffd9");
+	    Decoder decoder;
+	    orchis::assert_true(decoder.try_feed(v.data(), v.data() + v.size())
+				== S::IllegalLength);
+	    orchis::assert_true(decoder.try_feed(v.data(), v.data() + 2)
+				== S::IllegalLength);
+	    orchis::assert_true(decoder.try_end() == S::IllegalLength);
+	    orchis::assert_eq(decoder.v.size(), 2);
+	    orchis::assert_true(decoder.v[1] == Segment(0xe0, h("4711")));
+	}
+
+	void reset(orchis::TC)
+	{
+	    Decoder decoder;
+	    decode(decoder, h("ffd8 ffe0 0000"), 1);
+	    decoder.reset();
+	    orchis::assert_true(decoder.status() == S::Ok);
+	    orchis::assert_true(decode(decoder, h("ffd8 ffd9"), 1) == S::Ok);
+	}
+    }
 }
@@ -0,0 +1,28 @@
+#include <orchis.h>
+
+#include <metadata.h>
+
+namespace metadata {
+
+    using orchis::TC;
+    using orchis::assert_eq;
+
+    const Metadata meta {Serial {1},
+			 exif::DateTimeOriginal {std::string {"2019:11:20 12:34:56"}},
+			 wgs84::Coordinate {0, 0}};
+
+    void jpeg(TC)
+    {
+	assert_eq(meta.neighbor_of("P1010001.JPG"), "2019-11-20_0001.jpg");
+	assert_eq(meta.neighbor_of("p1010001.jpeg"), "2019-11-20_0001.jpg");
+	assert_eq(meta.neighbor_of("foo/P1010001.JPG"), "foo/2019-11-20_0001.jpg");
+	assert_eq(meta.neighbor_of("P1010001"), "2019-11-20_0001.jpg");
+    }
+
+    void raw(TC)
+    {
+	assert_eq(meta.neighbor_of("P1010001.ORF"), "2019-11-20_0001.ORF");
+	assert_eq(meta.neighbor_of("foo.d/P1010001.orf"), "foo.d/2019-11-20_0001.orf");
+	assert_eq(meta.filename(), "2019-11-20_0001.jpg");
+    }
+}
@@ -0,0 +1,50 @@
+#include <orchis.h>
+
+#include <ordered.h>
+
+namespace ordered {
+
+    using orchis::assert_eq;
+
+    std::vector<unsigned> squares(unsigned threads, unsigned n)
+    {
+	std::vector<unsigned> v;
+	Ordered<unsigned, unsigned> pool {threads,
+					  [] (const unsigned& in) {
+					      return in * in;
+					  },
+					  [&v] (const unsigned& in,
+						unsigned& out) {
+					      orchis::assert_eq(out, in * in);
+					      v.push_back(in);
+					  }};
+	for (unsigned i = 0; i < n; i++) pool.push(i);
+	pool.end();
+	return v;
+    }
+
+    void assert_sequence(const std::vector<unsigned>& v, unsigned n)
+    {
+	assert_eq(v.size(), n);
+	for (unsigned i = 0; i < n; i++) assert_eq(v[i], i);
+    }
+
+    void empty(orchis::TC)
+    {
+	assert_sequence(squares(1, 0), 0);
+	assert_sequence(squares(4, 0), 0);
+    }
+
+    void serial(orchis::TC)
+    {
+	assert_sequence(squares(1, 1), 1);
+	assert_sequence(squares(1, 1000), 1000);
+    }
+
+    void parallel(orchis::TC)
+    {
+	assert_sequence(squares(2, 1), 1);
+	assert_sequence(squares(2, 1000), 1000);
+	assert_sequence(squares(7, 1000), 1000);
+    }
+}
@@ -0,0 +1,48 @@
+#include <orchis.h>
+#include "hexread.h"
+
+#include <sniff.h>
+
+#include <vector>
+
+namespace format {
+
+    using orchis::TC;
+
+    void assert_sniffs(const std::string& s, Format ref)
+    {
+	const std::vector<uint8_t> v = hexread(s);
+	orchis::assert_true(sniff(v.data(), v.data() + v.size()) == ref);
+    }
+
+    void jpeg(TC)
+    {
+	assert_sniffs("ffd8 ffe0 0010 4a464946 0001", Format::Jpeg);
+	assert_sniffs("ffd8 ffe1", Format::Jpeg);
+	assert_sniffs("ff", Format::Jpeg);
+    }
+
+    void tiff(TC)
+    {
+	assert_sniffs("4949 2a00 0800 0000", Format::Tiff);
+	assert_sniffs("4d4d 002a 0000 0008", Format::Tiff);
+	assert_sniffs("4949 524f 0800 0000", Format::Tiff);
+	assert_sniffs("4d4d 4f52 0000 0008", Format::Tiff);
+	assert_sniffs("4949 5500 1800 0000", Format::Tiff);
+    }
+
+    void bmff(TC)
+    {
+	assert_sniffs("0000 0018 66747970 68656963", Format::Bmff);
+	assert_sniffs("0000 0020 66747970 69736f6d", Format::Bmff);
+    }
+
+    void unknown(TC)
+    {
+	assert_sniffs("", Format::Unknown);
+	assert_sniffs("6e6f7420 61206a70 6567", Format::Unknown);
+	assert_sniffs("4949 2b00 0800 0000", Format::Unknown);
+	assert_sniffs("4949 2a", Format::Unknown);
+	assert_sniffs("0000 0018 6674", Format::Unknown);
+    }
+}
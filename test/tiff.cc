@@ -1,4 +1,5 @@
 #include <vector>
+#include <cstdio>
 #include <orchis.h>
 #include "hexread.h"
 
@@ -198,6 +199,64 @@ namespace tiff {
 	}
     }
 
+    void view(const std::vector<uint8_t>& data)
+    {
+	const File f {data};
+	const auto s = f.ifd0.view<Short>(0x204);
+	assert_eq(s.size(), 5);
+	assert_eq(s[0], 0x4711);
+	assert_eq(s[4], 0x4715);
+	assert_true(Short::array_type(s.begin(), s.end()) ==
+		    Short::array_type({0x4711, 0x4712, 0x4713, 0x4714, 0x4715}));
+
+	const auto r = f.ifd0.view<Rational>(0x403);
+	assert_eq(r.size(), 3);
+	unsigned n = 0;
+	for (auto val : r) {
+	    n++;
+	    assert_true(val == std::make_pair(1u, n));
+	}
+
+	assert_true(f.ifd0.view<Long>(0x100).empty());
+	assert_true(f.ifd0.view<Long>(0x201).empty());
+
+	const StringView a = f.ifd0.view<Ascii>(0x104);
+	assert_eq(a, "fobar");
+	assert_eq(a, std::string {"fobar"});
+	assert_true(a!="fob");
+	assert_eq(a.str(), "fobar");
+	assert_true(f.ifd0.view<Ascii>(0x102).empty());
+    }
+
+    void extract(const std::vector<uint8_t>& data)
+    {
+	const File f {data};
+	Field<Byte, 0x004, 5> b5;
+	Field<Ascii, 0x104> a;
+	Field<Ascii, 0x103> foo;
+	Field<Short, 0x202> s1;
+	Field<Long, 0x303, 3> l3;
+	Field<Rational, 0x403, 3> r3;
+	Field<Long, 0x302, 2> wrong_count;
+	Field<Long, 0x202> wrong_type;
+	Field<Short, 0x100> missing;
+	f.ifd0.extract(r3, b5, a, foo, s1, l3, wrong_count, wrong_type, missing);
+
+	assert_true(*b5.val == std::array<uint8_t, 5>{0xde, 0xad, 0xf0,
+						      0x0d, 0x69});
+	assert_eq(a.val, "fobar");
+	assert_eq(foo.val, "foo");
+	assert_eq(*s1.val, 0x4711);
+	assert_true(*l3.val == std::array<unsigned, 3>{0x0df0adde,
+						       0xedc0edfe,
+						       0xadabbeba});
+	using R = std::pair<unsigned, unsigned>;
+	assert_true(*r3.val == std::array<R, 3>{R{1, 1}, R{1, 2}, R{1, 3}});
+	assert_false(wrong_count.val.has_value());
+	assert_false(wrong_type.val.has_value());
+	assert_false(missing.val.has_value());
+    }
+
     namespace intel {
 
 	using orchis::TC;
@@ -216,6 +275,8 @@ namespace tiff {
 	    void byte_array(TC) { tiff::optional::byte_array(data); }
 	    void one_long(TC)	{ tiff::optional::one_long(data); }
 	}
+	void view(TC)		{ tiff::view(data); }
+	void extract(TC)	{ tiff::extract(data); }
     }
 
     namespace motorola {
@@ -287,6 +348,8 @@ namespace tiff {
 	    void byte_array(TC) { tiff::optional::byte_array(data); }
 	    void one_long(TC)	{ tiff::optional::one_long(data); }
 	}
+	void view(TC)		{ tiff::view(data); }
+	void extract(TC)	{ tiff::extract(data); }
     }
 
     namespace broken {
@@ -296,7 +359,8 @@ namespace tiff {
 
 	void assert_empty(const char* s)
 	{
-	    const File f {h(exif + s)};
+	    const auto v = h(exif + s);
+	    const File f {v};
 	    orchis::assert_true(f.ifd0.empty());
 	    orchis::assert_true(f.exif.empty());
 	    orchis::assert_true(f.gps.empty());
@@ -360,5 +424,426 @@ namespace tiff {
 	    assert_throws<Error>("004d 002a 00000008 0000 00000000");
 	    assert_throws<Error>("0000 002a 00000008 0000 00000000");
 	}
+
+	void extract(TC)
+	{
+	    const auto v = h(exif + "4949 2a00 08000000 0100"
+			     "0301 0200 08000000 ffffff7f"
+			     "00000000");
+	    const File f {v};
+	    Field<Ascii, 0x103> a;
+	    try {
+		f.ifd0.extract(a);
+	    }
+	    catch (const Segfault&) {
+		return;
+	    }
+	    throw orchis::Failure {"should have thrown"};
+	}
+    }
+
+    namespace raw {
+
+	using orchis::TC;
+
+	const File::Raw raw;
+
+	const auto intel = h("4949 524f 0800 0000"  // ORF header
+			     "0100"
+			     "1001 0200 04000000 666f6f00"
+			     "00000000");
+	const auto motorola = h("4d4d 4f52 0000 0008"
+				"0001"
+				"0110 0002 00000004 666f6f00"
+				"00000000");
+
+	void orf(TC)
+	{
+	    const File a {raw, Range {intel}};
+	    assert_eq(a.ifd0.find<Ascii>(0x110), "foo");
+	    const File b {raw, Range {motorola}};
+	    assert_eq(b.ifd0.find<Ascii>(0x110), "foo");
+	}
+
+	void tiff(TC)
+	{
+	    const auto v = h("4949 2a00 0800 0000"
+			     "0100"
+			     "1001 0200 04000000 666f6f00"
+			     "00000000");
+	    const File f {raw, Range {v}};
+	    assert_eq(f.ifd0.find<Ascii>(0x110), "foo");
+	}
+
+	void not_app1(TC)
+	{
+	    auto v = h("45 78 69 66 00 00");
+	    v.insert(end(v), begin(intel), end(intel));
+	    try {
+		const File f {v};
+	    }
+	    catch (const Error&) {
+		return;
+	    }
+	    throw orchis::Failure {"should have thrown"};
+	}
+
+	void short_header(TC)
+	{
+	    const auto v = h("4949 524f 0800");
+	    try {
+		const File f {raw, Range {v}};
+	    }
+	    catch (const Segfault&) {
+		return;
+	    }
+	    throw orchis::Failure {"should have thrown"};
+	}
+
+	void status(TC)
+	{
+	    Status status = Status::Segfault;
+	    const File f {raw, Range {intel}, status};
+	    assert_true(status==Status::Ok);
+	    assert_eq(f.ifd0.find<Ascii>(0x110), "foo");
+	}
+    }
+
+    namespace status {
+
+	using orchis::TC;
+
+	const File::Raw raw;
+
+	void assert_status(const std::vector<uint8_t>& v, Status ref)
+	{
+	    Status status;
+	    const File f {raw, Range {v}, status};
+	    assert_true(status==ref);
+	}
+
+	void short_header(TC)
+	{
+	    assert_status(h("4949 2a00 0800"), Status::Segfault);
+	}
+
+	void magic(TC)
+	{
+	    assert_status(h("4949 2b00 0800 0000"
+			    "0000 00000000"), Status::Error);
+	    assert_status(h("494d 2a00 0800 0000"
+			    "0000 00000000"), Status::Error);
+	}
+
+	void ifd_offset(TC)
+	{
+	    assert_status(h("4949 2a00 ffff ff7f"), Status::Segfault);
+	    assert_status(h("4949 2a00 0800 0000"
+			    "0200"
+			    "1001 0200 04000000 666f6f00"), Status::Segfault);
+	}
+
+	void value_offset(TC)
+	{
+	    const auto v = h("4949 2a00 0800 0000"
+			     "0100"
+			     "1001 0200 08000000 ffffff7f"
+			     "00000000");
+	    Status status;
+	    const File f {raw, Range {v}, status};
+	    assert_true(status==Status::Ok);
+	    f.ifd0.find(0x110, Ascii::type, status);
+	    assert_true(status==Status::Segfault);
+	}
+
+	void not_app1(TC)
+	{
+	    Status status;
+	    const auto v = h("45 78 69 67 00 00"
+			     "4949 2a00 0800 0000"
+			     "0000 00000000");
+	    const File f {Range {v}, status};
+	    assert_true(status==Status::Error);
+	}
+    }
+
+    namespace order {
+
+	using orchis::TC;
+
+	const File::Raw raw;
+
+	void unsorted(TC)
+	{
+	    const auto v = h("4949 2a00 0800 0000"
+			     "0300"
+			     "0300 0300 01000000 0300ffff"
+			     "0100 0300 01000000 0100ffff"
+			     "0200 0300 01000000 0200ffff"
+			     "00000000");
+	    const File f {raw, Range {v}};
+	    for (unsigned tag : {1, 2, 3}) {
+		assert_true(f.ifd0.find<Short>(tag) == Short::array_type {uint16_t(tag)});
+	    }
+	    assert_true(f.ifd0.find<Short>(4).empty());
+	    assert_true(f.ifd0.find<Short>(0).empty());
+	}
+
+	void repeated(TC)
+	{
+	    const auto v = h("4949 2a00 0800 0000"
+			     "0400"
+			     "0100 0300 01000000 0100ffff"
+			     "0200 0400 01000000 02000000"
+			     "0200 0300 01000000 0300ffff"
+			     "0300 0300 01000000 0400ffff"
+			     "00000000");
+	    const File f {raw, Range {v}};
+	    assert_true(f.ifd0.find<Short>(2) == Short::array_type {3});
+	    assert_true(f.ifd0.find<Long>(2) == Long::array_type {2});
+	    assert_true(f.ifd0.find<Short>(3) == Short::array_type {4});
+	}
+
+	void sorted(TC)
+	{
+	    std::string s = "4949 2a00 0800 0000 ff00";
+	    for (unsigned tag = 1; tag < 0x100; tag++) {
+		char buf[40];
+		std::snprintf(buf, sizeof buf, "%02x00 0300 01000000 %02x00ffff",
+			      tag, tag);
+		s += buf;
+	    }
+	    s += "00000000";
+	    const auto v = h(s);
+	    const File f {raw, Range {v}};
+	    for (unsigned tag = 0; tag < 0x102; tag++) {
+		const auto val = f.ifd0.find<Short>(tag);
+		if (tag==0 || tag > 0xff) {
+		    assert_true(val.empty());
+		}
+		else {
+		    assert_true(val == Short::array_type {uint16_t(tag)});
+		}
+	    }
+	}
+    }
+
+    namespace inside {
+
+	using orchis::TC;
+
+	const File::Raw raw;
+
+	const auto v = h("4949 2a00 0800 0000"
+			 "0300"
+			 "0100 0200 08000000 32000000"
+			 "0200 0200 08000000 ffffff7f"
+			 "0300 0200 08000000 33000000"
+			 "00000000"
+			 "666f6f6261722100 0000");
+
+	void good(TC)
+	{
+	    const File f {raw, Range {v}};
+	    assert_eq(f.ifd0.find<Ascii>(1), "foobar!");
+	    Field<Ascii, 1> a;
+	    Field<Ascii, 3> b;
+	    f.ifd0.extract(a, b);
+	    assert_eq(a.val, "foobar!");
+	    assert_eq(b.val, "oobar!");
+	}
+
+	void bad(TC)
+	{
+	    const File f {raw, Range {v}};
+	    try {
+		f.ifd0.find<Ascii>(2);
+	    }
+	    catch (const Segfault&) {
+		return;
+	    }
+	    throw orchis::Failure {"should have thrown"};
+	}
+
+	/* More fields than there are marks for: tags 1--300, all
+	 * "foobar!" except for 2 and 290.
+	 */
+	std::vector<uint8_t> many_fields()
+	{
+	    const unsigned n = 300;
+	    const unsigned at = 8 + 2 + n*12 + 4;
+	    std::vector<uint8_t> v = h("4949 2a00 0800 0000");
+	    auto put16 = [&v] (unsigned n) {
+			     v.push_back(n & 0xff);
+			     v.push_back(n >> 8);
+			 };
+	    auto put32 = [&put16] (unsigned n) {
+			     put16(n & 0xffff);
+			     put16(n >> 16);
+			 };
+	    put16(n);
+	    for (unsigned tag = 1; tag <= n; tag++) {
+		put16(tag);
+		put16(2);
+		put32(8);
+		put32(tag==2 || tag==290 ? 0x7fffffff : at);
+	    }
+	    put32(0);
+	    for (char ch : std::string {"foobar!"}) v.push_back(ch);
+	    v.push_back(0);
+	    return v;
+	}
+
+	void many(TC)
+	{
+	    const auto v = many_fields();
+	    const File f {raw, Range {v}};
+	    Status status = Status::Ok;
+	    for (unsigned tag : {1, 256, 257, 289, 291, 300}) {
+		assert_eq(f.ifd0.find<Ascii>(tag), "foobar!");
+	    }
+	    for (unsigned tag : {2, 290}) {
+		f.ifd0.find(tag, Ascii::type, status);
+		assert_true(status==Status::Segfault);
+		status = Status::Ok;
+	    }
+	}
+    }
+
+    namespace chain {
+
+	using orchis::TC;
+	using v = Short::array_type;
+
+	const File::Raw raw;
+
+	/* The IFDs in the chain in 'data', as their Short 0x0001s.
+	 */
+	std::vector<unsigned> walk(const std::vector<uint8_t>& data,
+				   Status ref)
+	{
+	    std::vector<unsigned> acc;
+	    Status status;
+	    const File f {raw, Range {data}, status};
+	    for (Chain c {f, status}; !c.done(); c.next()) {
+		const auto n = c.ifd().find<Short>(1);
+		acc.push_back(n.empty() ? 0 : n[0]);
+	    }
+	    assert_true(status==ref);
+	    return acc;
+	}
+
+	const auto three = h("4949 2a00 0800 0000"
+			     "0100 0100 0300 01000000 0100 0000 1a000000"
+			     "0100 0100 0300 01000000 0200 0000 2c000000"
+			     "0100 0100 0300 01000000 0300 0000 00000000");
+
+	const auto interop = h("4949 2a00 0800 0000"
+			       "0100 6987 0400 01000000 1a000000 00000000"
+			       "0100 05a0 0400 01000000 2c000000 00000000"
+			       "0100 0100 0200 04000000 52393800 00000000");
+
+	void ifd1(TC)
+	{
+	    const File f {raw, Range {three}};
+	    assert_true(f.ifd0.find<Short>(1) == v{1});
+	    assert_true(f.ifd1().find<Short>(1) == v{2});
+	}
+
+	void no_ifd1(TC)
+	{
+	    const File f {raw, Range {interop}};
+	    assert_true(f.ifd1().empty());
+	}
+
+	void ifd1_segfault(TC)
+	{
+	    const auto data = h("4949 2a00 0800 0000"
+				"0100 0100 0300 01000000 0100 0000 ffffff7f");
+	    Status status;
+	    const File f {raw, Range {data}, status};
+	    assert_true(status==Status::Ok);
+	    assert_true(f.ifd1(status).empty());
+	    assert_true(status==Status::Segfault);
+	    try {
+		f.ifd1();
+	    }
+	    catch (const Segfault&) {
+		return;
+	    }
+	    throw orchis::Failure {"should have thrown"};
+	}
+
+	void leftover(TC)
+	{
+	    const File f {raw, Range {three}};
+	    Status status = Status::Segfault;
+	    assert_true(f.ifd1(status).find<Short>(1) == v{2});
+	    assert_true(status==Status::Ok);
+
+	    const File g {raw, Range {interop}};
+	    status = Status::Error;
+	    assert_eq(g.interop(status).find<Ascii>(1), "R98");
+	    assert_true(status==Status::Ok);
+
+	    status = Status::Error;
+	    unsigned n = 0;
+	    for (Chain c {f, status}; !c.done(); c.next()) n++;
+	    assert_eq(n, 3);
+	    assert_true(status==Status::Ok);
+	}
+
+	void again(TC)
+	{
+	    const auto data = h("4949 2a00 0800 0000"
+				"0100 0100 0300 01000000 0100 0000 ffffff7f");
+	    const File f {raw, Range {data}};
+	    for (Status status : {Status::Ok, Status::Error}) {
+		assert_true(f.ifd1(status).empty());
+		assert_true(status==Status::Segfault);
+	    }
+
+	    const File g {raw, Range {three}};
+	    const File copy = g;
+	    assert_true(copy.ifd1().find<Short>(1) == v{2});
+	    assert_true(g.ifd1().find<Short>(1) == v{2});
+	}
+
+	void interop_ifd(TC)
+	{
+	    const File f {raw, Range {interop}};
+	    assert_eq(f.interop().find<Ascii>(1), "R98");
+	    const File g {raw, Range {three}};
+	    assert_true(g.interop().empty());
+	}
+
+	void walk(TC)
+	{
+	    using u = std::vector<unsigned>;
+	    assert_true(walk(three, Status::Ok) == u({1, 2, 3}));
+	    assert_true(walk(interop, Status::Ok) == u({0}));
+	}
+
+	void loop(TC)
+	{
+	    using u = std::vector<unsigned>;
+	    const auto self = h("4949 2a00 0800 0000"
+				"0100 0100 0300 01000000 0100 0000 08000000");
+	    assert_true(walk(self, Status::Error) == u({1}));
+
+	    const auto two = h("4949 2a00 0800 0000"
+			       "0100 0100 0300 01000000 0100 0000 1a000000"
+			       "0100 0100 0300 01000000 0200 0000 08000000");
+	    assert_true(walk(two, Status::Error) == u({1, 2, 1}));
+	}
+
+	void segfault(TC)
+	{
+	    using u = std::vector<unsigned>;
+	    const auto data = h("4949 2a00 0800 0000"
+				"0100 0100 0300 01000000 0100 0000 1a000000"
+				"0100 0100 0300 01000000 0200 0000");
+	    assert_true(walk(data, Status::Segfault) == u({1, 0}));
+	}
     }
 }
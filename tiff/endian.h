@@ -13,33 +13,33 @@ namespace tiff {
 
     /**
      * Consuming unsigned 8-, 16- and 32-bit scalars from an uint8_t
-     * array, with some, as of yet undecided, endianness.
+     * array, big-endian (Motorola) or little-endian (Intel).
      *
-     * It's stupid to have detailed processing like this rely on
-     * run-time polymorphism, and not to template them with an
-     * iterator type as a parameter.  I blame the TIFF standard for
-     * the unusual and daft choice to leave endianness undecided.
+     * The TIFF standard leaves endianness undecided until you read
+     * the file header; I blame it for that unusual and daft choice.
      * It's only good for people implementing non-portable TIFF
      * writers; everyone else suffers.
+     *
+     * But it's decided once per file, so it doesn't have to be
+     * decided again for every octet.  The parsing is templated on
+     * Motorola or Intel, and a ByteOrder picks one of the two when
+     * it's time to parse something: see dispatch().
      */
     struct Endian {
 	using It = const uint8_t*;
-	virtual ~Endian() = default;
-	inline unsigned eat8(It& a) const { return *(a++); }
-	virtual unsigned eat16(It& a) const = 0;
-	virtual unsigned eat32(It& a) const = 0;
+	static unsigned eat8(It& a) { return *(a++); }
     };
 
-    struct Motorola final : public Endian {
+    struct Motorola : public Endian {
 
-	inline unsigned eat16(It& a) const
+	static unsigned eat16(It& a)
 	{
 	    unsigned n = eat8(a) << 8;
 	    n |= eat8(a);
 	    return n;
 	}
 
-	inline unsigned eat32(It& a) const
+	static unsigned eat32(It& a)
 	{
 	    unsigned n = eat16(a) << 16;
 	    n |= eat16(a);
@@ -47,21 +47,38 @@ namespace tiff {
 	}
     };
 
-    struct Intel final : public Endian {
+    struct Intel : public Endian {
 
-	inline unsigned eat16(It& a) const
+	static unsigned eat16(It& a)
 	{
 	    unsigned n = eat8(a);
 	    n |= eat8(a) << 8;
 	    return n;
 	}
 
-	inline unsigned eat32(It& a) const
+	static unsigned eat32(It& a)
 	{
 	    unsigned n = eat16(a);
 	    n |= eat16(a) << 16;
 	    return n;
 	}
     };
+
+    enum class ByteOrder {
+	Intel,
+	Motorola
+    };
+
+    /**
+     * f(Intel {}) or f(Motorola {}), depending on 'order'.  f is
+     * typically a generic lambda, so both versions are compiled, with
+     * the octet shuffling inlined.
+     */
+    template <class F>
+    auto dispatch(ByteOrder order, F f) -> decltype(f(Intel {}))
+    {
+	if (order==ByteOrder::Motorola) return f(Motorola {});
+	return f(Intel {});
+    }
 }
 #endif
@@ -11,6 +11,24 @@ namespace tiff {
 
     class Error {};
     class Segfault: public Error {};
+
+    /**
+     * The same errors, for the non-throwing API.
+     */
+    enum class Status {
+	Ok,
+	Error,
+	Segfault
+    };
+
+    inline void raise(Status status)
+    {
+	switch (status) {
+	case Status::Ok: break;
+	case Status::Error: throw Error {};
+	case Status::Segfault: throw Segfault {};
+	}
+    }
 }
 
 #endif
@@ -61,6 +61,15 @@ namespace tiff {
 	iterator end() const { return b; }
 	std::size_t size() const { return b-a; }
 
+	/**
+	 * True if there's a subrange at a certain offset and of a
+	 * certain length, i.e. if constructing it wouldn't throw.
+	 */
+	bool has(unsigned offset, unsigned len) const
+	{
+	    return offset <= size() && len <= size() - offset;
+	}
+
     private:
 	const iterator a;
 	const iterator b;
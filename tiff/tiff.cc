@@ -8,6 +8,7 @@
 #include "endian.h"
 
 #include <algorithm>
+#include <initializer_list>
 
 
 using namespace tiff;
@@ -24,49 +25,115 @@ namespace {
 	return it==begin(haystack);
     }
 
-    bool equal(const Range& r, const std::vector<uint8_t>& v)
+    bool equal(const Range& r, std::initializer_list<uint8_t> v)
     {
 	return r.size()==v.size() && std::equal(r.begin(), r.end(), v.begin());
     }
 
+    /**
+     * Note 'err' in 'status', unless something already went wrong.
+     */
+    void fail(Status& status, Status err)
+    {
+	if (status==Status::Ok) status = err;
+    }
+
+    /**
+     * The subrange of 'whole' at a certain offset and of a certain
+     * length, or the empty range and a Segfault in 'status' if
+     * there's no such thing.
+     */
+    Range sub(const Range& whole, unsigned offset, unsigned len,
+	      Status& status)
+    {
+	if (!whole.has(offset, len)) {
+	    fail(status, Status::Segfault);
+	    return {};
+	}
+	return {whole, offset, len};
+    }
+
     /**
      * What should be TIFF of an APP1 segment: the stuff after an Exif
-     * marker.  Throws if there's no Exif marker or no TIFF header
+     * marker.  Fails if there's no Exif marker or no TIFF header
      * (the header content is validated later).
      */
-    Range tiff_of(const std::vector<uint8_t>& app1)
+    Range tiff_of(const Range& app, Status& status)
     {
-	const Range app {app1};
-	const Range exif {app, 0, 6};
-	if (!equal(exif, {'E','x','i','f',0,0})) throw Error {};
+	const Range exif = sub(app, 0, 6, status);
+	if (status!=Status::Ok) return {};
+	if (!equal(exif, {'E','x','i','f',0,0})) {
+	    fail(status, Status::Error);
+	    return {};
+	}
 
 	const Range tiff {app, exif};
-	Range {tiff, 0, 8};
+	sub(tiff, 0, 8, status);
 	return tiff;
     }
 
     /**
-     * The endianness of a TIFF header; throws if it's neither Intel
-     * nor Motorola.
+     * A raw TIFF file; fails if it's too small to have a header.
      */
-    std::unique_ptr<Endian> endianness_of(const Range& tiff)
+    Range raw_of(const Range& tiff, Status& status)
     {
-	const Range endianness {tiff, 0, 4};
+	sub(tiff, 0, 8, status);
+	return tiff;
+    }
+
+    /**
+     * True if 'magic' is what should follow the byte order mark in
+     * a TIFF header: 42, or in a raw file one of the variations I
+     * know of.
+     */
+    bool magic(unsigned magic, bool raw)
+    {
+	if (magic==42) return true;
+	if (!raw) return false;
+	switch (magic) {
+	case 0x4f52:	// Olympus ORF "IIRO", "MMOR"
+	case 0x5352:	// Olympus ORF "IIRS"
+	case 0x0055:	// Panasonic RW2
+	    return true;
+	}
+	return false;
+    }
+
+    /**
+     * The endianness of a TIFF header; fails if it's neither Intel
+     * nor Motorola.  This is where the endianness of the whole File
+     * is decided.
+     */
+    ByteOrder endianness_of(const Range& tiff, bool raw, Status& status)
+    {
+	if (status!=Status::Ok) return ByteOrder::Intel;
+	const Range endianness = sub(tiff, 0, 4, status);
+	if (status!=Status::Ok) return ByteOrder::Intel;
+
 	auto it = std::begin(endianness);
-	std::unique_ptr<Endian> p;
-	switch (*it) {
-	case 'M':
-	    p.reset(new Motorola); break;
-	case 'I':
-	    p.reset(new Intel); break;
-	default:
-	    throw Error {};
+	const unsigned m0 = Endian::eat8(it);
+	const unsigned m1 = Endian::eat8(it);
+	if (m0!=m1 || (m0!='M' && m0!='I')) {
+	    fail(status, Status::Error);
+	    return ByteOrder::Intel;
 	}
-	unsigned m0 = p->eat8(it);
-	unsigned m1 = p->eat8(it);
-	unsigned fortytwo = p->eat16(it);
-	if (m0!=m1 || fortytwo != 42) throw Error {};
-	return p;
+	const ByteOrder order = m0=='M' ? ByteOrder::Motorola
+					: ByteOrder::Intel;
+	const unsigned fortytwo = dispatch(order, [&it] (const auto& en) {
+						       return en.eat16(it);
+						   });
+	if (!magic(fortytwo, raw)) fail(status, Status::Error);
+	return order;
+    }
+
+    unsigned eat16(ByteOrder order, Endian::It& it)
+    {
+	return dispatch(order, [&it] (const auto& en) { return en.eat16(it); });
+    }
+
+    unsigned eat32(ByteOrder order, Endian::It& it)
+    {
+	return dispatch(order, [&it] (const auto& en) { return en.eat32(it); });
     }
 
     /**
@@ -74,13 +141,16 @@ namespace {
      * returned is the 12-octet IFD entries, excluding the field count
      * and the final next IFD offset.
      */
-    Range ifd_of(const Endian& en, const Range& tiff, unsigned offset)
+    Range ifd_of(ByteOrder order, const Range& tiff, unsigned offset,
+		 Status& status)
     {
-	const Range count {tiff, offset, 2};
+	const Range count = sub(tiff, offset, 2, status);
+	if (status!=Status::Ok) return {};
 	auto it = std::begin(count);
-	unsigned n = en.eat16(it);
-	const Range entries {tiff, count, n*12};
-	const Range next {tiff, entries, 4};
+	unsigned n = eat16(order, it);
+	const Range entries = sub(tiff, offset + 2, n*12, status);
+	sub(tiff, offset + 2 + n*12, 4, status);	// the next IFD offset
+	if (status!=Status::Ok) return {};
 	return entries;
     }
 
@@ -88,32 +158,72 @@ namespace {
      * The first IFD in the TIFF file 'tiff', which is large enough to
      * contain the initial IFD offset.
      */
-    Range ifd_of(const Endian& en, const Range& tiff)
+    Range ifd_of(ByteOrder order, const Range& tiff, Status& status)
     {
+	if (status!=Status::Ok) return {};
 	auto it = std::begin(tiff);
 	it += 4;
-	unsigned offset = en.eat32(it);
-	return ifd_of(en, tiff, offset);
+	unsigned offset = eat32(order, it);
+	return ifd_of(order, tiff, offset, status);
     }
 
     /**
      * The IFD at the offset pointed out by a tiff::Long in 'ifd'.
      * This is how you find the Exif and GPS IFDs in IFD 0.
      */
-    Range ifd_of(const Range& tiff, const Ifd& ifd, const unsigned tag)
+    Range ifd_of(const Range& tiff, const Ifd& ifd, const unsigned tag,
+		 Status& status)
     {
-	const auto offset = find<type::Long>(ifd, tag);
-	if (!offset) return {};
-	return ifd_of(ifd.endian, tiff, *offset);
+	if (status!=Status::Ok) return {};
+	const Range r = ifd.find(tag, type::Long::type, status);
+	if (r.size()!=type::Long::size) return {};
+	auto it = std::begin(r);
+	return ifd_of(ifd.order, tiff, eat32(ifd.order, it), status);
+    }
+
+    Status& cleared(Status& status)
+    {
+	status = Status::Ok;
+	return status;
     }
 }
 
 File::File(const std::vector<uint8_t>& app1)
-    : tiff {tiff_of(app1)},
-      endian {endianness_of(tiff)},
-      ifd0 {*endian, tiff, ifd_of(*endian, tiff)},
-      exif {*endian, tiff, ifd_of(tiff, ifd0, 0x8769)},
-      gps  {*endian, tiff, ifd_of(tiff, ifd0, 0x8825)}
+    : File {Range {app1}}
+{}
+
+File::File(const Range& app1)
+    : File {app1, false, Checked {}}
+{}
+
+File::File(const Range& app1, Status& status)
+    : File {app1, false, cleared(status)}
+{}
+
+File::File(Raw, const Range& tiff)
+    : File {tiff, true, Checked {}}
+{}
+
+File::File(Raw, const Range& tiff, Status& status)
+    : File {tiff, true, cleared(status)}
+{}
+
+/**
+ * The throwing constructors end up here: the File is parsed without
+ * throwing, and then an exception is thrown if that failed.
+ */
+File::File(const Range& data, bool raw, Checked checked)
+    : File {data, raw, checked.status}
+{
+    raise(checked.status);
+}
+
+File::File(const Range& data, bool raw, Status& status)
+    : tiff {raw ? raw_of(data, status) : tiff_of(data, status)},
+      order {endianness_of(tiff, raw, status)},
+      ifd0 {order, tiff, ifd_of(order, tiff, status)},
+      exif {order, tiff, ifd_of(tiff, ifd0, 0x8769, status)},
+      gps  {order, tiff, ifd_of(tiff, ifd0, 0x8825, status)}
 {}
 
 namespace {
@@ -145,25 +255,97 @@ namespace {
 	}
 	return 0;
     }
+
+    /**
+     * What an Ifd finds out about itself, up front: which of its
+     * fields have values outside the File, marked in 'bad' (with the
+     * last mark bad if there are too many fields) and if the fields
+     * are sorted by tag, as they should be (repeated tags are
+     * accepted).  Returns the latter.
+     */
+    template <class E, class Marks>
+    bool checks_of(const E& endian, const Range& tiff, const Range& ifd,
+		   Marks& bad)
+    {
+	bool sorted = true;
+	unsigned prev = 0;
+	size_t i = 0;
+	auto a = std::begin(ifd);
+	while (a!=std::end(ifd)) {
+	    const unsigned tag = endian.eat16(a);
+	    const unsigned type = endian.eat16(a);
+	    const unsigned count = endian.eat32(a);
+	    const unsigned offset = endian.eat32(a);
+	    if (tag < prev) sorted = false;
+	    prev = tag;
+	    const unsigned n = size(type, count);
+	    if (i < bad.size()) bad[i++] = n>4 && !tiff.has(offset, n);
+	    else bad[bad.size() - 1] = true;
+	}
+	return sorted;
+    }
+
+    /**
+     * The first field in sorted 'ifd' with a tag not less than 'tag',
+     * or the end of it.
+     */
+    template <class E>
+    Range::iterator lower_bound(const E& endian, const Range& ifd,
+				const unsigned tag)
+    {
+	auto a = std::begin(ifd);
+	size_t n = ifd.size() / 12;
+	while (n) {
+	    const size_t half = n/2;
+	    auto mid = a + half*12;
+	    auto it = mid;
+	    if (endian.eat16(it) < tag) {
+		a = mid + 12;
+		n -= half + 1;
+	    }
+	    else {
+		n = half;
+	    }
+	}
+	return a;
+    }
+}
+
+Ifd::Ifd(ByteOrder order, const Range& tiff, const Range& ifd)
+    : order{order},
+      tiff{tiff},
+      ifd{ifd}
+{
+    sorted = dispatch(order, [&] (const auto& en) {
+				 return checks_of(en, tiff, ifd, bad);
+			     });
 }
 
 /**
- * The value of the first 'tag' of type 'type', or else the empty
- * range.
+ * find(tag, type, status) with endianness E.  If the IFD is sorted
+ * the search starts at the first field with 'tag', and ends after
+ * the last one.  The value of a field not marked as bad isn't
+ * checked again.
  */
-Range Ifd::find(const unsigned tag, const unsigned type) const
+template <class E>
+Range Ifd::find_in(const E& endian, const unsigned tag, const unsigned type,
+		   Status& status) const
 {
-    auto a = std::begin(ifd);
+    auto a = sorted ? lower_bound(endian, ifd, tag) : std::begin(ifd);
     const auto b = std::end(ifd);
     while (a!=b) {
-	if (endian.eat16(a)!=tag)  { a += 10; continue; }
+	const unsigned t = endian.eat16(a);
+	if (sorted && t > tag) break;
+	if (t!=tag)  { a += 10; continue; }
 	if (endian.eat16(a)!=type) { a += 8; continue; }
 	const unsigned count = endian.eat32(a);
 
 	unsigned n = size(type, count);
 	if (n>4) {
 	    const unsigned offset = endian.eat32(a);
-	    return {tiff, offset, n};
+	    if (good(a)) return {tiff.begin() + offset,
+				 tiff.begin() + offset + n};
+	    return sub(tiff, offset, n, status);
 	}
 	else {
 	    return {a, a + n};
@@ -171,3 +353,133 @@ Range Ifd::find(const unsigned tag, const unsigned type) const
     }
     return {};
 }
+
+/**
+ * The value of the first 'tag' of type 'type', or else the empty
+ * range.
+ */
+Range Ifd::find(const unsigned tag, const unsigned type) const
+{
+    Status status = Status::Ok;
+    const Range r = find(tag, type, status);
+    raise(status);
+    return r;
+}
+
+/**
+ * Like find(tag, type) but doesn't throw: if the value isn't inside
+ * the File, it fails with a Segfault in 'status'.
+ */
+Range Ifd::find(const unsigned tag, const unsigned type,
+		Status& status) const
+{
+    return dispatch(order, [&] (const auto& en) {
+	return find_in(en, tag, type, status);
+    });
+}
+
+/**
+ * IFD 1, i.e. the one following IFD 0, if there is one.
+ */
+Ifd File::ifd1() const
+{
+    Status status;
+    const Ifd ifd = ifd1(status);
+    raise(status);
+    return ifd;
+}
+
+/**
+ * Like ifd1() but doesn't throw: 'status' tells if it went well,
+ * like with the constructors.  If it didn't, the Ifd is empty.
+ */
+Ifd File::ifd1(Status& status) const
+{
+    cleared(status);
+    return ifd_at(next_of(first(), status), status);
+}
+
+/**
+ * The Interoperability IFD, pointed out by the Exif IFD, if there
+ * is one.
+ */
+Ifd File::interop() const
+{
+    Status status;
+    const Ifd ifd = interop(status);
+    raise(status);
+    return ifd;
+}
+
+Ifd File::interop(Status& status) const
+{
+    return {order, tiff, ifd_of(tiff, exif, 0xa005, cleared(status))};
+}
+
+/**
+ * The offset of IFD 0.
+ */
+unsigned File::first() const
+{
+    auto it = std::begin(tiff) + 4;
+    return eat32(order, it);
+}
+
+/**
+ * The offset of the IFD following the one at 'offset', or 0 if
+ * there's none.
+ */
+unsigned File::next_of(unsigned offset, Status& status) const
+{
+    const Range entries = ifd_of(order, tiff, offset, status);
+    if (status!=Status::Ok) return 0;
+    auto it = std::end(entries);
+    return eat32(order, it);
+}
+
+/**
+ * The IFD at 'offset', or an empty one if the offset is 0.
+ */
+Ifd File::ifd_at(unsigned offset, Status& status) const
+{
+    if (!offset) return {order, tiff, Range {}};
+    return {order, tiff, ifd_of(order, tiff, offset, status)};
+}
+
+/**
+ * The start of a walk, at IFD 0.  Like the File constructors, it
+ * starts by clearing 'status'.
+ */
+Chain::Chain(const File& file, Status& status)
+    : file{file},
+      status{cleared(status)},
+      offset{file.first()},
+      tortoise{offset}
+{}
+
+Ifd Chain::ifd() const
+{
+    return file.ifd_at(offset, status);
+}
+
+/**
+ * Step to the next IFD.  The tortoise stays at one IFD while we
+ * take 1, 2, 4 ... steps; if we meet it, we're going in circles.
+ */
+void Chain::next()
+{
+    offset = file.next_of(offset, status);
+    if (!offset) return;
+
+    lambda++;
+    if (offset==tortoise) {
+	fail(status, Status::Error);
+	offset = 0;
+	return;
+    }
+    if (lambda==power) {
+	tortoise = offset;
+	power *= 2;
+	lambda = 0;
+    }
+}
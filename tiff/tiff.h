@@ -8,8 +8,10 @@
 #define OLYMP_TIFF_H
 
 #include "range.h"
+#include "error.h"
 #include "type.h"
 #include "endian.h"
+#include "view.h"
 
 #include <cstdint>
 #include <vector>
@@ -17,6 +19,9 @@
 #include <algorithm>
 #include "optional.h"
 #include <array>
+#include <bitset>
+#include <string>
+#include <initializer_list>
 
 namespace tiff {
 
@@ -27,37 +32,62 @@ namespace tiff {
      * One Range contains the N 12-octet fields of the IFD (but not
      * the count and next IFD offset); another contains the whole
      * File.
+     *
+     * TIFF says the fields are sorted by tag, in ascending order.  If
+     * they are (which is checked once, up front) a field is found by
+     * binary search; otherwise by looking at them all.
+     *
+     * Likewise, it's checked up front if the value of each field is
+     * inside the File, and the ones which aren't are marked as bad.
+     * Finding the value of a good field is then just pointer
+     * arithmetic, and only the bad ones are looked at again (and
+     * fail).  There are 256 marks; in the unlikely case of more
+     * fields, the last mark stands for all the rest, and is bad.
      */
     class Ifd {
     public:
 	Ifd() = default;
-	Ifd(const Endian& endian,
-	    const Range& tiff, const Range& ifd)
-	    : endian{endian},
-	      tiff{tiff},
-	      ifd{ifd}
-	{}
+	Ifd(ByteOrder order,
+	    const Range& tiff, const Range& ifd);
 
 	bool empty() const { return ifd.size()==0; }
 
 	template <class T>
 	typename T::array_type find(unsigned tag) const;
+	template <class T>
+	View<T> view(unsigned tag) const;
+	Range find(unsigned tag, unsigned type, Status& status) const;
 
-	const Endian& endian;
+	template <class... F>
+	void extract(F&... fields) const;
+
+	const ByteOrder order;
 
     private:
 	Range tiff;
 	Range ifd;
+	bool sorted;
+	std::bitset<256> bad;
 
 	Range find(unsigned tag, unsigned type) const;
+	template <class E>
+	Range find_in(const E& en, unsigned tag, unsigned type,
+		      Status& status) const;
+	bool good(Range::iterator end) const;
+
+	template <class F, class E>
+	void visit(const E& en, Range::iterator entry,
+		   unsigned tag, unsigned type,
+		   F& field, bool& seen, unsigned& left) const;
     };
 
     /**
      * Find the first field with a certain tag and of a certain
-     * tiff::Type.  Typically returns a vector: e.g. for a tiff::Long
-     * field, it returns std::vector<unsigned>.
+     * tiff::Type, and view its values where they are.  Typically
+     * returns Values<T>: e.g. for a tiff::Long field, a sequence of
+     * unsigned, decoded as you go.
      *
-     * Returns an empty vector if no matching field is found.  Thus
+     * Returns an empty view if no matching field is found.  Thus
      * you cannot distinguish between a kind-of valid field with count
      * 0, the absence of that field, or the presence of the tag but
      * with the wrong type.
@@ -69,20 +99,13 @@ namespace tiff {
      * need and the ones that are easy.
      */
     template <class T>
-    typename T::array_type Ifd::find(unsigned tag) const
+    View<T> Ifd::view(unsigned tag) const
     {
-	const Range r = find(tag, T::type);
-	typename T::array_type v;
-	auto a = r.begin();
-	const auto b = r.end();
-	while (a!=b) {
-	    v.push_back(T(endian, a).val);
-	}
-	return v;
+	return {order, find(tag, T::type)};
     }
 
     /**
-     * Like Ifd::find<T>(tag) in general, but returns a std::string.
+     * Like Ifd::view<T>(tag) in general, but returns a StringView.
      *
      * TIFF has some support for arrays of strings, but this function
      * hasn't.  On the other hand, it supports skipping the \0
@@ -90,11 +113,21 @@ namespace tiff {
      * non-ASCII text.
      */
     template <> inline
-    type::Ascii::array_type Ifd::find<type::Ascii>(unsigned tag) const
+    StringView Ifd::view<type::Ascii>(unsigned tag) const
     {
-	const Range r = find(tag, type::Ascii::type);
-	auto e = std::find(r.begin(), r.end(), '\0');
-	return {r.begin(), e};
+	return StringView {find(tag, type::Ascii::type)};
+    }
+
+    /**
+     * Like Ifd::view<T>(tag), but copies the values: e.g. for a
+     * tiff::Long field, it returns std::vector<unsigned>, and for
+     * tiff::Ascii a std::string.
+     */
+    template <class T>
+    typename T::array_type Ifd::find(unsigned tag) const
+    {
+	const auto v = view<T>(tag);
+	return {v.begin(), v.end()};
     }
 
     /**
@@ -110,10 +143,10 @@ namespace tiff {
 							     unsigned tag)
     {
 	optional<std::array<typename T::value_type, Count>> val;
-	const auto v = ifd.find<T>(tag);
+	const auto v = ifd.view<T>(tag);
 	if (v.size() == Count) {
 	    std::array<typename T::value_type, Count> arr;
-	    std::copy(begin(v), end(v), begin(arr));
+	    std::copy(v.begin(), v.end(), begin(arr));
 	    val = arr;
 	}
 	return val;
@@ -129,13 +162,146 @@ namespace tiff {
 					  unsigned tag)
     {
 	optional<typename T::value_type> val;
-	const auto v = ifd.find<T>(tag);
+	const auto v = ifd.view<T>(tag);
 	if (v.size() == 1) {
 	    val = v[0];
 	}
 	return val;
     }
 
+    /**
+     * A field with a certain tag and tiff::Type, for Ifd::extract()
+     * to fill in.  Like with the find() functions, the value is an
+     * optional array of Count values, an optional value if Count is
+     * 1, or a StringView for tiff::Ascii.  Nothing is allocated.
+     */
+    template <class T, unsigned Tag, unsigned Count = 1>
+    struct Field {
+	static constexpr unsigned tag = Tag;
+	static constexpr unsigned count = Count;
+	using Type = T;
+
+	optional<std::array<typename Type::value_type, count>> val;
+    };
+
+    template <class T, unsigned Tag>
+    struct Field<T, Tag, 1> {
+	static constexpr unsigned tag = Tag;
+	static constexpr unsigned count = 1;
+	using Type = T;
+
+	optional<typename Type::value_type> val;
+    };
+
+    template <unsigned Tag>
+    struct Field<type::Ascii, Tag, 1> {
+	static constexpr unsigned tag = Tag;
+	static constexpr unsigned count = 1;
+	using Type = type::Ascii;
+
+	StringView val;
+    };
+
+    namespace impl {
+
+	/**
+	 * Decode the 'count' values of type T at 'a' into 'val', if
+	 * it's the number of values 'val' wants.
+	 */
+	template <class T, class E>
+	void decode(const E& en, Range::iterator a, unsigned count,
+		    optional<typename T::value_type>& val)
+	{
+	    if (count!=1) return;
+	    val = T(en, a).val;
+	}
+
+	template <class T, class E, std::size_t N>
+	void decode(const E& en, Range::iterator a, unsigned count,
+		    optional<std::array<typename T::value_type, N>>& val)
+	{
+	    if (count!=N) return;
+	    std::array<typename T::value_type, N> arr;
+	    for (auto& v : arr) v = T(en, a).val;
+	    val = arr;
+	}
+
+	template <class T, class E>
+	void decode(const E&, Range::iterator a, unsigned count,
+		    StringView& val)
+	{
+	    val = StringView {Range {a, a + count}};
+	}
+    }
+
+    /**
+     * Fill in a number of Fields (of different types) in a single
+     * walk over the IFD, rather than by one find() each.  Each IFD
+     * entry is looked at once, and its value decoded straight into
+     * the Field it belongs to, if any.  The walk ends when all the
+     * Fields have been seen.
+     *
+     * As with find(), it's the first entry with the right tag and
+     * type which counts.  A Field which isn't found, or which has the
+     * wrong count, is left empty.
+     *
+     * Will throw on malformed TIFF data, such as an offset pointing
+     * outside the file.
+     */
+    template <class... F>
+    void Ifd::extract(F&... fields) const
+    {
+	dispatch(order, [&] (const auto& en) {
+	    bool seen[sizeof...(F)] = {};
+	    unsigned left = sizeof...(F);
+	    auto a = ifd.begin();
+	    const auto b = ifd.end();
+	    while (a!=b && left) {
+		auto entry = a;
+		const unsigned tag = en.eat16(entry);
+		const unsigned type = en.eat16(entry);
+		unsigned n = 0;
+		(void)std::initializer_list<int> {
+		    (visit(en, entry, tag, type, fields, seen[n++], left), 0)...
+		};
+		a += 12;
+	    }
+	    return 0;
+	});
+    }
+
+    /**
+     * Part of extract(): the IFD entry with 'tag' and 'type' and the
+     * count etc. at 'entry', considered for 'field'.
+     */
+    template <class F, class E>
+    void Ifd::visit(const E& en, Range::iterator entry,
+		    unsigned tag, unsigned type,
+		    F& field, bool& seen, unsigned& left) const
+    {
+	if (seen || tag!=F::tag || type!=F::Type::type) return;
+	seen = true;
+	left--;
+
+	const unsigned count = en.eat32(entry);
+	const unsigned n = F::Type::size * count;
+	if (n<=4) return impl::decode<typename F::Type>(en, entry, count, field.val);
+
+	const unsigned offset = en.eat32(entry);
+	if (!good(entry) && !tiff.has(offset, n)) throw Segfault {};
+	impl::decode<typename F::Type>(en, tiff.begin() + offset, count, field.val);
+    }
+
+    /**
+     * True if the field ending at 'end' is marked as good, i.e. its
+     * value is known to be inside the File.
+     */
+    inline bool Ifd::good(Range::iterator end) const
+    {
+	const size_t i = (end - ifd.begin()) / 12 - 1;
+	return !bad[std::min(i, bad.size() - 1)];
+    }
+
     /**
      * A TIFF file according to TIFF revision 6.0 (Adobe 1992).
      *
@@ -144,26 +310,98 @@ namespace tiff {
      * in the Exif and GPS IFDs, which can be found via IFD 0, if they
      * exist.
      *
-     * We don't look for any other IFDs.
+     * Other IFDs are only parsed if you ask for them: IFD 1 (which
+     * in Exif describes the thumbnail image), the Interoperability
+     * IFD, and the chain of IFDs starting with IFD 0 (see Chain).  An
+     * IFD which doesn't exist is empty.  Nothing is remembered: each
+     * call parses the IFD again, and returns it by value.  That's
+     * cheap, and it leaves a const File safe to share between
+     * threads, and to copy.
      *
      * The constructor will throw on error, for example if it's not
      * given an Exif APP1 segment, or if the TIFF file inside is
-     * malformed in any way. The vector needs to be present throughout
-     * the lifetime of the File; it is not copied.
+     * malformed in any way. The vector or Range needs to be present
+     * throughout the lifetime of the File; it is not copied.
+     *
+     * A File can also be a TIFF file of its own, not wrapped in an
+     * APP1 segment: the raw image files of many cameras are TIFF,
+     * with the Exif IFD etc. in the usual places.  Some of them have
+     * their own variations of the TIFF header (e.g. Olympus ORF has
+     * "IIRO" rather than "II*\0") and those are accepted too.
+     *
+     * The constructors with a Status don't throw.  Instead the
+     * Status tells if it went well; if it didn't, don't use the File.
      */
     class File {
     public:
 	explicit File(const std::vector<uint8_t>& app1);
+	explicit File(const Range& app1);
+	File(const Range& app1, Status& status);
+
+	struct Raw {};
+	File(Raw, const Range& tiff);
+	File(Raw, const Range& tiff, Status& status);
+
+	Ifd ifd1() const;
+	Ifd ifd1(Status& status) const;
+	Ifd interop() const;
+	Ifd interop(Status& status) const;
 
     private:
+	struct Checked { Status status = Status::Ok; };
+	File(const Range& data, bool raw, Checked checked);
+	File(const Range& data, bool raw, Status& status);
+
 	const Range tiff;
-	const std::unique_ptr<Endian> endian;
+	const ByteOrder order;
+
+	friend class Chain;
+	unsigned first() const;
+	unsigned next_of(unsigned offset, Status& status) const;
+	Ifd ifd_at(unsigned offset, Status& status) const;
 
     public:
 	Ifd ifd0;
 	Ifd exif;
 	Ifd gps;
     };
+
+    /**
+     * Walking the chain of IFDs in a File: IFD 0, IFD 1 and so on,
+     * each pointing out the next.  Raw files may have several.  An
+     * IFD is parsed when you get to it:
+     *
+     *   for (Chain chain {file, status}; !chain.done(); chain.next()) {
+     *       const Ifd ifd = chain.ifd();
+     *   }
+     *
+     * Like with File::ifd1(), nothing is remembered: walking the
+     * chain again parses the IFDs again.
+     *
+     * The walk ends with the last IFD, or with a corrupt one (which
+     * 'status' tells about).  It also ends if the chain loops back on
+     * itself, which would otherwise make it endless; that's a
+     * tiff::Status::Error.  The loop is found without remembering all
+     * IFDs (by Brent's algorithm) so by then you may have seen some
+     * of them twice.
+     */
+    class Chain {
+    public:
+	Chain(const File& file, Status& status);
+
+	bool done() const { return offset==0; }
+	Ifd ifd() const;
+	void next();
+
+    private:
+	const File& file;
+	Status& status;
+	unsigned offset;
+
+	unsigned tortoise;
+	unsigned power = 1;
+	unsigned lambda = 0;
+    };
 }
 
 #endif
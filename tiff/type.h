@@ -22,7 +22,8 @@ namespace tiff {
 	 * - the encoded size of a single element
 	 * and if we intend to actually decode:
 	 * - the value type (the array element type)
-	 * - how to extract a value from a Range
+	 * - how to extract a value from a Range, with a Motorola or
+	 *   Intel endianness
 	 */
 	template <unsigned T, unsigned Size>
 	struct Type {
@@ -35,8 +36,8 @@ namespace tiff {
 	    using array_type = std::vector<value_type>;
 	    const value_type val;
 
-	    template <class It>
-	    explicit Byte(const Endian& en, It& a) : val(en.eat8(a)) {}
+	    template <class E, class It>
+	    explicit Byte(const E& en, It& a) : val(en.eat8(a)) {}
 	};
 
 	struct Ascii: public Type<2, 1> {
@@ -48,8 +49,8 @@ namespace tiff {
 	    using array_type = std::vector<value_type>;
 	    const value_type val;
 
-	    template <class It>
-	    explicit Short(const Endian& en, It& a) : val(en.eat16(a)) {}
+	    template <class E, class It>
+	    explicit Short(const E& en, It& a) : val(en.eat16(a)) {}
 	};
 
 	struct Long: public Type<4, 4> {
@@ -57,14 +58,14 @@ namespace tiff {
 	    using array_type = std::vector<value_type>;
 	    const value_type val;
 
-	    template <class It>
-	    explicit Long(const Endian& en, It& a) : val(en.eat32(a)) {}
+	    template <class E, class It>
+	    explicit Long(const E& en, It& a) : val(en.eat32(a)) {}
 	};
 
 	namespace impl {
 
-	    template <class It>
-	    std::pair<unsigned, unsigned> eat_pair(const Endian& en, It& a)
+	    template <class E, class It>
+	    std::pair<unsigned, unsigned> eat_pair(const E& en, It& a)
 	    {
 		unsigned m = en.eat32(a);
 		unsigned n = en.eat32(a);
@@ -77,8 +78,8 @@ namespace tiff {
 	    using array_type = std::vector<value_type>;
 	    const value_type val;
 
-	    template <class It>
-	    explicit Rational(const Endian& en, It& a) : val{impl::eat_pair(en, a)} {}
+	    template <class E, class It>
+	    explicit Rational(const E& en, It& a) : val{impl::eat_pair(en, a)} {}
 	};
 
 	using Sbyte     = Type<6,  1>;
@@ -88,8 +89,8 @@ namespace tiff {
 	    using array_type = std::vector<value_type>;
 	    const value_type val;
 
-	    template <class It>
-	    explicit Undefined(const Endian& en, It& a) : val(en.eat8(a)) {}
+	    template <class E, class It>
+	    explicit Undefined(const E& en, It& a) : val(en.eat8(a)) {}
 	};
 
 	using Sshort    = Type<8,  2>;
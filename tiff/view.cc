@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#include "view.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+using tiff::StringView;
+
+/**
+ * The text in 'r', up to the first \0, if any.
+ */
+StringView::StringView(const Range& r)
+    : a {reinterpret_cast<iterator>(r.begin())},
+      b {std::find(a, a + r.size(), '\0')}
+{}
+
+bool StringView::operator== (const StringView& other) const
+{
+    return size()==other.size() && std::equal(a, b, other.a);
+}
+
+bool StringView::operator== (const std::string& s) const
+{
+    return size()==s.size() && std::equal(a, b, s.data());
+}
+
+bool StringView::operator== (const char* s) const
+{
+    return size()==std::strlen(s) && std::equal(a, b, s);
+}
+
+std::ostream& tiff::operator<< (std::ostream& os, const StringView& val)
+{
+    return os.write(val.begin(), val.size());
+}
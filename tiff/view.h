@@ -0,0 +1,128 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_TIFF_VIEW_H
+#define OLYMP_TIFF_VIEW_H
+
+#include "range.h"
+#include "endian.h"
+#include "type.h"
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <iosfwd>
+
+namespace tiff {
+
+    /**
+     * The values of a TIFF field of type T, as they are in the File:
+     * nothing is copied or allocated, and a value is decoded when you
+     * dereference the iterator.  Only good as long as the File data
+     * is.
+     */
+    template <class T>
+    class Values {
+    public:
+	using value_type = typename T::value_type;
+
+	class iterator {
+	public:
+	    using iterator_category = std::input_iterator_tag;
+	    using value_type = typename T::value_type;
+	    using difference_type = std::ptrdiff_t;
+	    using pointer = const value_type*;
+	    using reference = value_type;
+
+	    iterator(ByteOrder order, Range::iterator a)
+		: order{order},
+		  a{a}
+	    {}
+
+	    value_type operator* () const
+	    {
+		auto it = a;
+		return dispatch(order, [&it] (const auto& en) {
+					   return T(en, it).val;
+				       });
+	    }
+	    iterator& operator++ () { a += T::size; return *this; }
+	    iterator operator++ (int) { auto it = *this; ++*this; return it; }
+	    bool operator== (const iterator& other) const { return a==other.a; }
+	    bool operator!= (const iterator& other) const { return a!=other.a; }
+
+	private:
+	    ByteOrder order;
+	    Range::iterator a;
+	};
+
+	Values(ByteOrder order, const Range& r)
+	    : order{order},
+	      r{r}
+	{}
+
+	iterator begin() const { return {order, r.begin()}; }
+	iterator end() const { return {order, r.begin() + size() * T::size}; }
+	std::size_t size() const { return r.size() / T::size; }
+	bool empty() const { return size()==0; }
+	value_type operator[] (std::size_t n) const
+	{
+	    return *iterator {order, r.begin() + n * T::size};
+	}
+
+    private:
+	ByteOrder order;
+	Range r;
+    };
+
+    /**
+     * A tiff::type::Ascii value, as it is in the File; like C++17
+     * std::string_view.  It ends at the first \0 if there is one, and
+     * the text may be non-ASCII.
+     */
+    class StringView {
+    public:
+	using iterator = const char*;
+
+	StringView() : a{}, b{} {}
+	explicit StringView(const Range& r);
+
+	iterator begin() const { return a; }
+	iterator end() const { return b; }
+	std::size_t size() const { return b-a; }
+	bool empty() const { return a==b; }
+	char operator[] (std::size_t n) const { return a[n]; }
+	std::string str() const { return {a, b}; }
+
+	bool operator== (const StringView& other) const;
+	bool operator== (const std::string& s) const;
+	bool operator== (const char* s) const;
+	template <class S>
+	bool operator!= (const S& s) const { return !(*this==s); }
+
+    private:
+	iterator a;
+	iterator b;
+    };
+
+    inline
+    bool operator== (const std::string& s, const StringView& val)
+    {
+	return val==s;
+    }
+
+    std::ostream& operator<< (std::ostream& os, const StringView& val);
+
+    /**
+     * The view type for values of type T: Values<T>, or a StringView
+     * for tiff::type::Ascii.
+     */
+    template <class T> struct ViewOf { using type = Values<T>; };
+    template <> struct ViewOf<type::Ascii> { using type = StringView; };
+    template <class T> using View = typename ViewOf<T>::type;
+}
+
+#endif
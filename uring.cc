@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#include "uring.h"
+
+#include <cstring>
+#include <cerrno>
+#include <initializer_list>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define OLYMP_HAVE_URING
+#endif
+
+#ifdef OLYMP_HAVE_URING
+
+namespace {
+
+    int io_uring_setup(unsigned entries, io_uring_params* p)
+    {
+	return syscall(__NR_io_uring_setup, entries, p);
+    }
+
+    int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+		       unsigned flags)
+    {
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+		       flags, nullptr, 0);
+    }
+
+    template <class T>
+    T* at(void* p, unsigned offset)
+    {
+	return reinterpret_cast<T*>(static_cast<char*>(p) + offset);
+    }
+
+    unsigned load(const unsigned* p)
+    {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+    }
+
+    void store(unsigned* p, unsigned val)
+    {
+	__atomic_store_n(p, val, __ATOMIC_RELEASE);
+    }
+}
+
+Uring::Uring(unsigned n)
+{
+    io_uring_params p;
+    std::memset(&p, 0, sizeof p);
+    fd = io_uring_setup(n, &p);
+    if (fd==-1) return;
+
+    /* IORING_OP_OPENAT and friends came in Linux 5.6, together
+     * with this feature flag. Older kernels would just fail each
+     * request with EINVAL.
+     */
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+	::close(fd);
+	fd = -1;
+	return;
+    }
+
+    auto map = [this] (Map& m, size_t size, off_t offset) {
+		   void* p = mmap(nullptr, size, PROT_READ|PROT_WRITE,
+				  MAP_SHARED|MAP_POPULATE, fd, offset);
+		   if (p==MAP_FAILED) return false;
+		   m.p = p;
+		   m.size = size;
+		   return true;
+	       };
+
+    const size_t sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    const size_t cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool ok = map(sq_ring, sq_size, IORING_OFF_SQ_RING);
+    if (ok) ok = map(cq_ring, cq_size, IORING_OFF_CQ_RING);
+    if (ok) ok = map(sqes_map, p.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES);
+    if (!ok) {
+	unmap();
+	::close(fd);
+	fd = -1;
+	return;
+    }
+
+    entries = p.sq_entries;
+    sq_head = at<unsigned>(sq_ring.p, p.sq_off.head);
+    sq_tail = at<unsigned>(sq_ring.p, p.sq_off.tail);
+    sq_mask = *at<unsigned>(sq_ring.p, p.sq_off.ring_mask);
+    sq_array = at<unsigned>(sq_ring.p, p.sq_off.array);
+    sqes = static_cast<io_uring_sqe*>(sqes_map.p);
+
+    cq_head = at<unsigned>(cq_ring.p, p.cq_off.head);
+    cq_tail = at<unsigned>(cq_ring.p, p.cq_off.tail);
+    cq_mask = *at<unsigned>(cq_ring.p, p.cq_off.ring_mask);
+    cqes = at<io_uring_cqe>(cq_ring.p, p.cq_off.cqes);
+}
+
+Uring::~Uring()
+{
+    unmap();
+    if (fd!=-1) ::close(fd);
+}
+
+void Uring::unmap()
+{
+    for (Map* m : {&sqes_map, &cq_ring, &sq_ring}) {
+	if (m->p) munmap(m->p, m->size);
+	m->p = nullptr;
+    }
+}
+
+/**
+ * The next free submission queue entry, cleared.  There is one,
+ * since no more requests than there are entries are in flight.
+ */
+io_uring_sqe* Uring::sqe()
+{
+    const unsigned tail = *sq_tail;
+    const unsigned n = tail & sq_mask;
+    io_uring_sqe* const e = &sqes[n];
+    std::memset(e, 0, sizeof *e);
+    sq_array[n] = n;
+    store(sq_tail, tail + 1);
+    queued++;
+    return e;
+}
+
+void Uring::openat(int dirfd, const char* path, int flags, uint64_t data)
+{
+    io_uring_sqe* const e = sqe();
+    e->opcode = IORING_OP_OPENAT;
+    e->fd = dirfd;
+    e->addr = reinterpret_cast<uintptr_t>(path);
+    e->open_flags = flags;
+    e->user_data = data;
+}
+
+void Uring::read(int fd, void* buf, size_t count, off_t offset, uint64_t data)
+{
+    io_uring_sqe* const e = sqe();
+    e->opcode = IORING_OP_READ;
+    e->fd = fd;
+    e->addr = reinterpret_cast<uintptr_t>(buf);
+    e->len = count;
+    e->off = offset;
+    e->user_data = data;
+}
+
+void Uring::close(int fd, uint64_t data)
+{
+    io_uring_sqe* const e = sqe();
+    e->opcode = IORING_OP_CLOSE;
+    e->fd = fd;
+    e->user_data = data;
+}
+
+/**
+ * Submit the queued requests, and wait until at least 'wait'
+ * of them have completed.  Returns 0, or the errno value if it
+ * failed; then some requests may still be queued.
+ */
+int Uring::submit(unsigned wait)
+{
+    const unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+    int n;
+    do {
+	n = io_uring_enter(fd, queued, wait, flags);
+    } while (n==-1 && errno==EINTR);
+    if (n==-1) return errno;
+    queued -= n;
+    return 0;
+}
+
+/**
+ * Pop one completion, if there is one.
+ */
+bool Uring::reap(uint64_t& data, int& res)
+{
+    const unsigned head = *cq_head;
+    if (head==load(cq_tail)) return false;
+
+    const io_uring_cqe& e = cqes[head & cq_mask];
+    data = e.user_data;
+    res = e.res;
+    store(cq_head, head + 1);
+    return true;
+}
+
+#else
+
+Uring::Uring(unsigned) {}
+Uring::~Uring() {}
+void Uring::unmap() {}
+void Uring::openat(int, const char*, int, uint64_t) {}
+void Uring::read(int, void*, size_t, off_t, uint64_t) {}
+void Uring::close(int, uint64_t) {}
+int Uring::submit(unsigned) { return ENOSYS; }
+bool Uring::reap(uint64_t&, int&) { return false; }
+
+#endif
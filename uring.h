@@ -0,0 +1,82 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_URING_H
+#define OLYMP_URING_H
+
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/**
+ * A minimal io_uring(7) instance: just enough to queue openat(2),
+ * read(2) and close(2) requests, submit them all at once, and reap
+ * their completions.  Uses the system calls directly; liburing
+ * isn't worth depending on for this.
+ *
+ * If io_uring isn't available (not Linux, the kernel is too old, or
+ * it's disabled) the Uring is invalid, and the caller has to do its
+ * I/O the old way.
+ *
+ * Each request carries a 64-bit 'data' which comes back with its
+ * result: the file descriptor or octet count, or a negated errno
+ * value.  The caller must not have more requests in flight than the
+ * ring has entries; queued but not yet submitted ones count too.
+ *
+ * submit() returns an errno value if it fails.  EAGAIN and EBUSY are
+ * temporary: the kernel is short of resources, or has completions it
+ * cannot post until some are reaped.  Reap what you can and submit
+ * again.  Anything else means the ring is broken.
+ */
+class Uring {
+public:
+    explicit Uring(unsigned entries);
+    ~Uring();
+    Uring(const Uring&) = delete;
+    Uring& operator= (const Uring&) = delete;
+
+    bool valid() const { return fd != -1; }
+    unsigned size() const { return entries; }
+
+    void openat(int dirfd, const char* path, int flags, uint64_t data);
+    void read(int fd, void* buf, size_t count, off_t offset, uint64_t data);
+    void close(int fd, uint64_t data);
+
+    int submit(unsigned wait);
+    bool reap(uint64_t& data, int& res);
+
+private:
+    int fd = -1;
+    unsigned entries = 0;
+    unsigned queued = 0;
+
+    struct Map {
+	void* p = nullptr;
+	size_t size = 0;
+    };
+    Map sq_ring;
+    Map cq_ring;
+    Map sqes_map;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned* sq_array;
+    io_uring_sqe* sqes;
+
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe* cqes;
+
+    io_uring_sqe* sqe();
+    void unmap();
+};
+
+#endif
@@ -0,0 +1,59 @@
+/* -*- c++ -*-
+ *
+ * Copyright (c) 2026 Jrgen Grahn
+ * All rights reserved.
+ *
+ */
+#ifndef OLYMP_WALK_H
+#define OLYMP_WALK_H
+
+#include <string>
+#include <memory>
+#include <functional>
+
+/**
+ * An open directory, and its path.  The path is only for messages;
+ * the files in it are reached through 'fd'.
+ */
+struct Dir {
+    Dir(int fd, const std::string& path) : fd{fd}, path{path} {}
+    ~Dir();
+    Dir(const Dir&) = delete;
+    Dir& operator= (const Dir&) = delete;
+
+    const int fd;
+    const std::string path;
+};
+
+/**
+ * A file, as a name relative to a directory: an open Dir, or the
+ * current directory if 'dir' is null.  Names in the current directory
+ * are the ones given by the user, and may well be paths.
+ *
+ * Using openat(2) and friends on entries is cheaper than on paths
+ * (no path lookup from the root every time) and the full path only
+ * needs to be formed for messages.  The Dir stays open for as long
+ * as any of its entries is around.
+ */
+struct Entry {
+    Entry() = default;
+    explicit Entry(const std::string& name) : name{name} {}
+    Entry(const std::shared_ptr<const Dir>& dir, const std::string& name)
+	: dir{dir},
+	  name{name}
+    {}
+
+    int at() const;
+    std::string path() const;
+
+    std::shared_ptr<const Dir> dir;
+    std::string name;
+};
+
+using WalkError = std::function<void(const std::string& path, int err)>;
+
+void walk(const std::string& root,
+	  const std::function<void(const Entry&)>& f,
+	  const WalkError& error);
+
+#endif
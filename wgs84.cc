@@ -71,20 +71,31 @@ namespace {
     {
 	bool non_wgs = std::find(begin(data), end(data), datum.val) == end(data);
 	if (non_wgs) return 0;
-	auto it = signs.find(sign.val);
+	auto it = signs.find(sign.val.str());
 	if (it == end(signs)) return 0;
 	if (!digits.val) return 0;
 	return it->second * decode_triplet(*digits.val);
     }
+
+    /**
+     * The coordinate in the GPS IFD of 'file', with all the fields
+     * needed extracted in one go.
+     */
+    Coordinate coordinate_of(const tiff::File& file)
+    {
+	gps::MapDatum datum;
+	gps::LatitudeRef latref;
+	gps::Latitude lat;
+	gps::LongitudeRef lonref;
+	gps::Longitude lon;
+	file.gps.extract(datum, latref, lat, lonref, lon);
+	return {coord_of(datum, latref, lat),
+		coord_of(datum, lonref, lon)};
+    }
 }
 
 Coordinate::Coordinate(const tiff::File& file)
-    : longitude {coord_of(gps::MapDatum{file},
-			  gps::LongitudeRef{file},
-			  gps::Longitude{file})},
-      latitude {coord_of(gps::MapDatum{file},
-			 gps::LatitudeRef{file},
-			 gps::Latitude{file})}
+    : Coordinate {coordinate_of(file)}
 {}
 
 bool Coordinate::valid() const
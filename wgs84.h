@@ -28,6 +28,8 @@ namespace wgs84 {
 	explicit Coordinate(const tiff::File&);
 
 	bool valid() const;
+	double lat() const { return latitude; }
+	double lon() const { return longitude; }
 	std::ostream& put(std::ostream& os) const;
 	PJ_COORD lp() const;
 